@@ -9,8 +9,117 @@
 #include <iostream>
 #include <chrono>  
 #include <iomanip> 
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
 #define MAX 100
 
+/**
+ * @brief Espalha os bits de um código (finalizador do splitmix64).
+ *
+ * @details Usada pelo hash dos resumos e pelas sondas do filtro de Bloom.
+ * @param codigo O código.
+ */
+static inline uint64_t mistura(int codigo) {
+    uint64_t h = (uint64_t) (uint32_t) codigo + 0x9E3779B97F4A7C15ull;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+    return h ^ (h >> 31);
+}
+
+/**
+ * @class Resumo
+ * @brief Agregados dos atributos dos itens de uma subárvore.
+ *
+ * @details Guarda o número de itens e a soma, o mínimo e o máximo do estoque e do valor dos itens. Um resumo vazio tem mínimos e máximos neutros, de modo que acumular um resumo vazio não altera o resultado. Guarda também um hash dos códigos da subárvore: a soma (módulo 2^64) de uma mistura de cada código. Ele depende só do conjunto de códigos, e não do formato da árvore, então duas cópias com os mesmos códigos têm o mesmo hash em qualquer intervalo, mesmo balanceadas de formas diferentes.
+ */
+struct Resumo
+{
+    long long itens;
+    long long estoque_total;
+    long long estoque_min;
+    long long estoque_max;
+    double valor_total;
+    double valor_min;
+    double valor_max;
+    uint64_t hash;
+
+    /**
+     * @brief Construtor de um resumo vazio.
+     */
+    Resumo() :
+        itens(0),
+        estoque_total(0),
+        estoque_min(LLONG_MAX),
+        estoque_max(LLONG_MIN),
+        valor_total(0),
+        valor_min(HUGE_VAL),
+        valor_max(-HUGE_VAL),
+        hash(0)
+    {}
+
+    /**
+     * @brief Construtor do resumo de um único item.
+     * @param codigo Código do item.
+     * @param estoque Estoque do item.
+     * @param valor Valor do item.
+     */
+    Resumo(int codigo, long long estoque, double valor) :
+        itens(1),
+        estoque_total(estoque),
+        estoque_min(estoque),
+        estoque_max(estoque),
+        valor_total(valor),
+        valor_min(valor),
+        valor_max(valor),
+        hash(mistura(codigo))
+    {}
+
+    /**
+     * @brief Acumula outro resumo neste.
+     * @param r Resumo a ser acumulado.
+     */
+    inline void acumula(const Resumo &r) {
+        itens += r.itens;
+        estoque_total += r.estoque_total;
+        estoque_min = std::min(estoque_min, r.estoque_min);
+        estoque_max = std::max(estoque_max, r.estoque_max);
+        valor_total += r.valor_total;
+        valor_min = std::min(valor_min, r.valor_min);
+        valor_max = std::max(valor_max, r.valor_max);
+        hash += r.hash;
+    }
+};
+
 /**
  * @class No
  * @brief Classe que representa um nó em uma árvore AVL.
@@ -18,15 +127,21 @@
  * A classe No encapsula os atributos e métodos necessários para a manipulação de um nó em uma árvore AVL, incluindo a gestão de seus filhos, altura e fator de balanceamento. 
  *
  * @details Cada Nó é um produto dotado de código e sua altura na árvore. Além disso, cada nó possui um ponteiro para o nó pai, um para o nó à esquerda e outro para o nó à direita.
+ * @details O nó também guarda o estoque e o valor do item, e o resumo desses atributos em toda a sua subárvore.
  */
 class No 
 {
-    friend class AVL;
+    template <typename Politica> friend class ArvoreBalanceada;
+    friend struct BalanceamentoAVL;
+    friend struct BalanceamentoWAVL;
 
 private:
 
     int codigo;
     int altura;
+    long long estoque;
+    double valor;
+    Resumo resumo;
     No *mae;
     No *esq;
     No *dir;
@@ -36,10 +151,15 @@ public:
     /**
      * @brief Construtor da classe No.
      * @param codigo Código do nó.
+     * @param estoque Estoque do item.
+     * @param valor Valor do item.
      */
-    No(const int codigo) : 
+    No(const int codigo, long long estoque = 0, double valor = 0) : 
         codigo(codigo), 
         altura(0), 
+        estoque(estoque),
+        valor(valor),
+        resumo(codigo, estoque, valor),
         mae(nullptr), 
         esq(nullptr), 
         dir(nullptr) 
@@ -64,6 +184,34 @@ public:
     }
     
 
+    /**
+     * @brief Retorna o código do item.
+     */
+    inline int get_codigo() const {
+        return codigo;
+    }
+
+    /**
+     * @brief Retorna o estoque do item.
+     */
+    inline long long get_estoque() const {
+        return estoque;
+    }
+
+    /**
+     * @brief Retorna o valor do item.
+     */
+    inline double get_valor() const {
+        return valor;
+    }
+
+    /**
+     * @brief Retorna o resumo dos atributos da subárvore do nó.
+     */
+    inline const Resumo &get_resumo() const {
+        return resumo;
+    }
+
     /**
      * @brief Retorna se o nó é raiz.
      * @return true se o nó é raiz, false caso contrário.
@@ -119,765 +267,6929 @@ public:
         // Atualiza a altura do nó
         altura = 1 + (alt_esq > alt_dir ? alt_esq : alt_dir);
             // Se a altura da subárvore esquerda for maior que a da direita, a altura do nó é a da esquerda mais 1, senão, a da direita mais 1
+
+        // Os filhos podem ter mudado: o resumo também precisa ser refeito
+        atualiza_resumo();
+    }
+
+    /**
+     * @brief Refaz o resumo da subárvore a partir do item e dos resumos dos filhos.
+     */
+    inline void atualiza_resumo() {
+        resumo = Resumo(codigo, estoque, valor);
+        if (esq)
+            resumo.acumula(esq->resumo);
+        if (dir)
+            resumo.acumula(dir->resumo);
     }
 
 };
 
 /**
- * @class AVL
- * @brief Classe que representa uma árvore AVL (árvore binária de busca auto-balanceada).
- * 
- * @details A árvore AVL mantém seu balanceamento realizando rotações durante inserções e remoções. Isso garante que a árvore permaneça balanceada, proporcionando complexidade de tempo O(log n) para operações de busca, inserção e remoção.
+ * @class IndiceHash
+ * @brief Tabela hash de endereçamento aberto (Robin Hood) que associa códigos a nós.
+ *
+ * @details As entradas ficam em um único vetor e as colisões são resolvidas por sondagem linear. Na inserção, uma entrada mais próxima da sua posição ideal cede o lugar à que está mais longe, o que mantém as sequências de sondagem curtas; na remoção, as entradas seguintes são deslocadas de volta, sem marcas de remoção.
  */
-class AVL
+class IndiceHash
 {
 private:
-    
-    No *raiz; 
+
+    struct Entrada {
+        int codigo;
+        uint32_t distancia; // distância até a posição ideal mais 1; 0 indica entrada vazia
+        No *no;
+    };
+
+    std::vector<Entrada> tabela;
+    size_t mascara;
+    int bits;
+    size_t quantidade;
 
     /**
-     * @brief Insere um nó na árvore AVL.
-     * 
-     * @param z Ponteiro para o nó a ser inserido.
+     * @brief Retorna a posição ideal de um código (hash multiplicativo de Fibonacci).
+     * @param codigo O código.
      */
-    void insere(No *z) {
-        
-        // Auxiliares
-        No *y = nullptr;
-        No *x = raiz;
-
+    inline size_t posicao(int codigo) const {
+        return (size_t) (((uint64_t) (uint32_t) codigo * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+    }
 
-        while (x != nullptr) {
-            
-            // Aponta para o nó atual
-            y = x;
+    /**
+     * @brief Procura a entrada de um código.
+     * @param codigo O código procurado.
+     * @return Índice da entrada, ou -1 se o código não estiver na tabela.
+     */
+    long procura(int codigo) const {
+        size_t i = posicao(codigo);
+        for (uint32_t d = 1; ; d++) {
+            const Entrada &e = tabela[i];
+            if (e.distancia < d)
+                return -1;
+            if (e.codigo == codigo)
+                return i;
+            i = (i + 1) & mascara;
+        }
+    }
 
-            // Verifica se z é menor que a raiz
-            if (z->codigo < x->codigo) 
-                x = x->esq;
-            else 
-                x = x->dir;
+    /**
+     * @brief Coloca uma entrada nova na tabela, sem verificar se o código já existe.
+     * @param e A entrada.
+     */
+    void coloca(Entrada e) {
+        size_t i = posicao(e.codigo);
+        e.distancia = 1;
+        while (tabela[i].distancia != 0) {
+            if (tabela[i].distancia < e.distancia)
+                std::swap(tabela[i], e);
+            e.distancia++;
+            i = (i + 1) & mascara;
         }
+        tabela[i] = e;
+    }
 
-        // Definição da mãe de z
-        z->mae = y;
+    /**
+     * @brief Redimensiona a tabela e reposiciona todas as entradas.
+     * @param novos_bits Log2 da nova capacidade.
+     */
+    void redimensiona(int novos_bits) {
+        std::vector<Entrada> antiga;
+        antiga.swap(tabela);
+        bits = novos_bits;
+        tabela.assign((size_t) 1 << bits, Entrada());
+        mascara = tabela.size() - 1;
+        for (const Entrada &e : antiga)
+            if (e.distancia != 0)
+                coloca(e);
+    }
 
-        // Se a árvore estiver vazia, z é a raiz
-        if (y == nullptr) 
-            raiz = z;
-        else 
-            // Verifica se z é menor que o auxiliar
-            if (z->codigo < y->codigo) 
-                y->esq = z;
-            else 
-                y->dir = z;
+public:
 
-        // Verifica se z é raiz
-        if (z->eh_raiz())
-            return;
-        
-        // Ajusta o balanceamento da árvore
-        do { 
-            z = z->mae;
-            z = ajusta_balanceamento(z, true);
-        } while (
-            !z->eh_raiz() and z->bal() != 0
-        );
-    };
+    /**
+     * @brief Construtor de uma tabela vazia.
+     */
+    IndiceHash() : mascara(0), bits(0), quantidade(0) {
+        redimensiona(4);
+    }
 
     /**
-     * @brief Busca um nó com uma chave específica na árvore AVL.
-     * 
-     * @param x Ponteiro para o nó de onde a busca começa.
-     * @param k A chave a ser buscada.
-     * @return Ponteiro para o nó com a chave especificada, ou nullptr se não encontrado.
+     * @brief Busca o nó associado a um código.
+     * @param codigo O código procurado.
+     * @return Ponteiro para o nó, ou nullptr se o código não estiver na tabela.
      */
-    No *busca(No *x, int k) {
-        // Caso o nó inicial seja nulo ou a chave seja igual à chave do nó
-        if (x == nullptr || x->codigo == k)
-            return x;
-        // Caso a chave seja menor que a chave do nó, busca à esquerda
-        if (k < x->codigo) 
-            return busca(x->esq, k);
-        else
-            return busca(x->dir, k);
-    };
+    inline No *busca(int codigo) const {
+        long i = procura(codigo);
+        return i < 0 ? nullptr : tabela[i].no;
+    }
 
     /**
-     * @brief Encontra o nó com a menor chave a partir de um nó específico.
-     * 
-     * @param x Ponteiro para o nó de onde a busca começa.
-     * @return Ponteiro para o nó com a chave mínima.
+     * @brief Associa um código a um nó, se o código ainda não estiver na tabela.
+     * @param codigo O código.
+     * @param no O nó.
+     * @return true se o código foi inserido, false se já existia.
      */
-    No *minimo(No *x) {
-        // Enquanto houver um nó à esquerda, o nó atual é substituído pelo filho esquerdo
-        while (x->esq != nullptr) 
-            x = x->esq;
-        return x;
-    };
+    bool insere(int codigo, No *no) {
+        if (procura(codigo) >= 0)
+            return false;
+
+        // Fator de carga máximo de 7/8
+        if ((quantidade + 1) * 8 > tabela.size() * 7)
+            redimensiona(bits + 1);
+
+        Entrada e;
+        e.codigo = codigo;
+        e.no = no;
+        coloca(e);
+        quantidade++;
+        return true;
+    }
 
     /**
-     * @brief Encontra o nó com a maior chave a partir de um nó específico.
-     * 
-     * @param x Ponteiro para o nó de onde a busca começa.
-     * @return Ponteiro para o nó com a chave máxima.
+     * @brief Retira um código da tabela.
+     * @param codigo O código.
+     * @return true se o código foi retirado, false se não existia.
      */
-    No *maximo(No *x) {
-        // Enquanto houver um nó à direita, o nó atual é substituído pelo filho direito
-        while (x->dir != nullptr) 
-            x = x->dir;
-        return x;
-    };
+    bool remove(int codigo) {
+        long i = procura(codigo);
+        if (i < 0)
+            return false;
+
+        // Desloca as entradas seguintes uma posição para trás
+        size_t j = (i + 1) & mascara;
+        while (tabela[j].distancia > 1) {
+            tabela[i] = tabela[j];
+            tabela[i].distancia--;
+            i = j;
+            j = (j + 1) & mascara;
+        }
+        tabela[i].distancia = 0;
+        quantidade--;
+        return true;
+    }
 
     /**
-     * @brief Transplanta uma subárvore enraizada no nó v para a posição do nó u.
-     * 
-     * @param u Ponteiro para o nó a ser substituído.
-     * @param v Ponteiro para o nó que substituirá u.
+     * @brief Esvazia a tabela.
      */
-    void transplante(No *u, No *v) {
-        
-        if (u->eh_raiz()) 
-            raiz = v;
-        else if (u->eh_esquerdo()) 
-            u->mae->esq = v;
-        else 
-            u->mae->dir = v;
-        
-        // Se houver um nó v
-        if (v != nullptr) 
-            // O nó v recebe a mãe do nó u
-            v->mae = u->mae;
-    };
+    void limpa() {
+        quantidade = 0;
+        tabela.clear();
+        redimensiona(4);
+    }
 
     /**
-     * @brief Ajusta o balanceamento da árvore AVL após inserção ou remoção.
-     * 
-     * @param p Ponteiro para o nó de onde o ajuste de balanceamento começa.
-     * @param girou Booleano indicando se uma rotação ocorreu.
-     * @return Ponteiro para o nó após o ajuste de balanceamento.
+     * @brief Retorna o número de códigos na tabela.
      */
-    No *ajusta_balanceamento(No *p, bool girou) {
-        
-        // Atualiza a altura do nó
-        p->atualiza_altura();
-        
-        // Obtém o balanceamento do nó
-        int balance = p->bal();
+    size_t tamanho() const {
+        return quantidade;
+    }
 
-        // Caso 1: Se o balanceamento de p for 2, o nó está desbalanceado para a esquerda | Rotação à direita ou dupla à direita.
-        if (balance == 2) {
+    /**
+     * @brief Retorna o número de posições da tabela.
+     */
+    size_t capacidade() const {
+        return tabela.size();
+    }
 
-            // Se o fator de balanceamento do filho esquerdo for maior ou igual a zero
-            if (p->esq->bal() >= 0) { 
-                
-                // Caso 1.1: Rotação à direita  
-                if (girou) 
-                    // std::cout << ">> Rotação direita (Caso 1.1)\n";
-                rotacao_dir(p);
+    /**
+     * @brief Retorna a memória ocupada pela tabela, em bytes.
+     */
+    size_t memoria() const {
+        return sizeof(*this) + tabela.size() * sizeof(Entrada);
+    }
+};
 
-            } else { // Se o fator de balanceamento do filho esquerdo for menor que zero
-                
-                // Caso 1.2: Rotação dupla direita
-                if (girou) 
-                    // std::cout << ">> Rotação dupla direita (Caso 1.2)\n";
-                rotacao_dupla_dir(p);
+/**
+ * @class FiltroBloom
+ * @brief Filtro de Bloom em blocos para descartar rapidamente códigos ausentes.
+ *
+ * @details Cada código acende k bits dentro de um único bloco de 512 bits (uma linha de cache), de modo que cada consulta toca uma só linha de memória. O filtro nunca dá falso negativo; um resultado positivo pode ser falso, com taxa que cresce à medida que o filtro enche. Remoções não apagam bits: o dono do filtro deve reconstruí-lo quando houver remoções demais.
+ */
+class FiltroBloom
+{
+private:
 
-            }
-            
-            // Atualiza o nó mãe
-            p = p->mae;
+    static const int PALAVRAS_BLOCO = 8; // 8 palavras de 64 bits = 512 bits
 
-        } else
-            
-            // Caso 2: Se o balanceamento for -2, o nó está desbalanceado para a direita | Rotação à esquerda ou dupla à esquerda.
-            if (balance == -2) {
-                
-                // Se o fator de balanceamento do filho direito for menor ou igual a zero
-                if (p->dir->bal() <= 0) {
+    std::vector<uint64_t> bits;
+    size_t num_blocos;
+    size_t cap;
+    int bits_por_codigo;
+    int k;
+    size_t quantidade;
+    size_t remocoes;
 
-                    // Caso 2.1: Rotação à esquerda
-                    if (girou) 
-                        // std::cout << ">> Rotação esquerda (Caso 2.1)\n";
-                    rotacao_esq(p);
-                
-                } else { // Se o fator de balanceamento do filho direito for maior que zero
-                    
-                    // Caso 2.2: Rotação dupla esquerda
-                    if (girou) 
-                        // std::cout << ">> Rotação dupla esquerda (Caso 2.2)\n";
-                    rotacao_dupla_esq(p);
-                }
-                // Atualiza o nó mãe
-                p = p->mae;
-            }
-        
-        // Retorna o nó após o ajuste de balanceamento
-        return p;
-    };
+    // Contadores de consultas (preservados na reconstrução)
+    mutable long long consultas;
+    mutable long long descartes;
+    long long falsos_positivos;
+
+public:
 
     /**
-     * @brief Remove um nó da árvore AVL.
-     * 
-     * @param z Ponteiro para o nó a ser removido.
+     * @brief Construtor do filtro.
+     * @param capacidade Número de códigos previsto.
+     * @param bits_por_codigo Bits do filtro por código (10 dá cerca de 1% de falsos positivos).
      */
-    void remove(No *z) {
-        
-        
-        No *p = nullptr;
-        
-        if (z->esq == nullptr) { 
+    FiltroBloom(size_t capacidade, int bits_por_codigo = 10) :
+        bits_por_codigo(bits_por_codigo),
+        consultas(0),
+        descartes(0),
+        falsos_positivos(0)
+    {
+        // Número ótimo de bits por código: (m / n) ln 2
+        k = (int) (bits_por_codigo * 0.693 + 0.5);
+        k = k < 1 ? 1 : (k > 16 ? 16 : k);
+        refaz(capacidade);
+    }
 
-            p = z->mae; 
-            transplante(z, z->dir);
+    /**
+     * @brief Esvazia o filtro e o redimensiona para uma nova capacidade.
+     * @param capacidade Número de códigos previsto.
+     */
+    void refaz(size_t capacidade) {
+        cap = capacidade < 64 ? 64 : capacidade;
+        num_blocos = (cap * bits_por_codigo + 511) / 512;
+        bits.assign(num_blocos * PALAVRAS_BLOCO, 0);
+        quantidade = 0;
+        remocoes = 0;
+    }
+
+    /**
+     * @brief Acrescenta um código ao filtro.
+     * @param codigo O código.
+     */
+    void insere(int codigo) {
+        uint64_t h = mistura(codigo);
+        uint64_t *bloco = &bits[((h >> 32) * num_blocos >> 32) * PALAVRAS_BLOCO];
+        uint32_t h1 = (uint32_t) h, h2 = (uint32_t) (h >> 41) | 1;
+        for (int i = 0; i < k; i++) {
+            uint32_t b = (h1 + i * h2) & 511;
+            bloco[b >> 6] |= (uint64_t) 1 << (b & 63);
         }
-        else {
-            
-            if (z->dir == nullptr) { 
-                // printf("<< Remoção 2o caso\n");
-                p = z->mae; 
-                transplante(z, z->esq);
-            }
-            else { 
-                No *y = minimo(z->dir);
-            
-                // printf("<< Remoção 3o caso (a) ");
-                if (y->mae != z) { 
-                    printf("+ (b)\n");
-                    p = y->mae; 
-                    transplante(y, y->dir); 
-                    y->dir = z->dir;
-                    y->dir->mae = y;
-                }
-                printf("\n");
-            
-                transplante(z, y); // (a)
-                y->esq = z->esq;
-                y->esq->mae = y;
+        quantidade++;
+    }
 
-                if (p == nullptr) 
-                    p = y;
+    /**
+     * @brief Verifica se um código pode estar no conjunto.
+     * @param codigo O código.
+     * @return false se o código certamente não está no conjunto.
+     */
+    bool talvez_contem(int codigo) const {
+        uint64_t h = mistura(codigo);
+        const uint64_t *bloco = &bits[((h >> 32) * num_blocos >> 32) * PALAVRAS_BLOCO];
+        uint32_t h1 = (uint32_t) h, h2 = (uint32_t) (h >> 41) | 1;
+        consultas++;
+        for (int i = 0; i < k; i++) {
+            uint32_t b = (h1 + i * h2) & 511;
+            if (!(bloco[b >> 6] & ((uint64_t) 1 << (b & 63)))) {
+                descartes++;
+                return false;
             }
         }
-
-        
-        if (p == NULL)
-            return;
-        
-    
-        p = ajusta_balanceamento(p, false);
-        
-        while (!p->eh_raiz() and p->bal() != 1 and p->bal() != -1) { 
-            p = p->mae;
-            p = ajusta_balanceamento(p, false);
-        }
-    };
+        return true;
+    }
 
     /**
-     * @brief Limpa a árvore AVL a partir de um nó específico.
-     * 
-     * @param x Ponteiro para o nó de onde a limpeza começa.
+     * @brief Registra uma remoção no conjunto (os bits do código continuam acesos).
      */
-    void limpa(No *x) {
-        if (x == NULL)
-            return;
+    void conta_remocao() {
+        remocoes++;
+    }
 
-        limpa(x->esq);
-        limpa(x->dir);
-        delete x;
-    };
+    /**
+     * @brief Registra que uma resposta positiva do filtro se mostrou falsa.
+     */
+    void registra_falso_positivo() {
+        falsos_positivos++;
+    }
 
     /**
-     * @brief Copia uma árvore AVL para a árvore atual a partir da raiz.
-     * 
-     * @param T Referência para a árvore AVL a ser copiada.
+     * @brief Indica se o filtro deve ser reconstruído: cheio além da capacidade ou com remoções demais.
      */
-    void copia(const AVL& T) {
-        if (T.raiz == nullptr)
-            raiz = nullptr;
-        else {
-            raiz = new No(T.raiz->codigo);
-            copia(raiz, T.raiz);
-        }
-    };
+    bool precisa_refazer() const {
+        return quantidade > cap || remocoes * 4 > quantidade + 64;
+    }
 
     /**
-     * @brief Copia uma subárvore de um nó de origem para um nó de destino.
-     * 
-     * @param dest Ponteiro para o nó de destino.
-     * @param orig Ponteiro para o nó de origem.
+     * @brief Retorna a taxa de falsos positivos medida nas consultas a códigos ausentes.
      */
-    void copia(No *dest, No *orig) {
-        if (orig->esq) {
-            dest->esq = new No(orig->esq->codigo);
-            dest->esq->mae = dest;
-            copia(dest->esq, orig->esq);
-        }
-        
-        if (orig->dir) {
-            dest->dir = new No(orig->dir->codigo);
-            dest->dir->mae = dest;
-            copia(dest->dir, orig->dir);
-        }
-    };
+    double taxa_falsos_medida() const {
+        long long negativos = descartes + falsos_positivos;
+        return negativos ? (double) falsos_positivos / negativos : 0.0;
+    }
 
     /**
-     * @brief Realiza uma rotação à direita em um nó específico.
-     * 
-     * @param p Ponteiro para o nó a ser rotacionado.
+     * @brief Retorna a taxa de falsos positivos estimada pela fração de bits acesos.
      */
-    void rotacao_dir(No *p) {
-        
-        No *u = p->esq;
-        
-        // arruma u e sua mãe (a mãe de p)
-        transplante(p, u);
-        
-        // move p para a direita de u, e o filho direito de u para a esquerda de p
-        p->mae = u;
-        p->esq = u->dir;
-        u->dir = p;
-        
-        if (p->esq) {
-            // arruma a mãe do filho esquerdo de p
-            p->esq->mae = p;
-        }
+    double taxa_falsos_estimada() const {
+        size_t acesos = 0;
+        for (uint64_t w : bits)
+            acesos += __builtin_popcountll(w);
+        return std::pow((double) acesos / (bits.size() * 64), k);
+    }
 
-        // atualiza alturas
-        p->atualiza_altura();
-        u->atualiza_altura();
-    };
+    size_t tamanho() const { return quantidade; }
+    long long get_consultas() const { return consultas; }
+    long long get_descartes() const { return descartes; }
+    long long get_falsos_positivos() const { return falsos_positivos; }
 
     /**
-     * @brief Realiza uma rotação à esquerda em um nó específico.
-     * 
-     * @param p Ponteiro para o nó a ser rotacionado.
+     * @brief Retorna a memória ocupada pelo filtro, em bytes.
      */
-    void rotacao_esq(No *p) {
-        
-        No *u = p->dir;
-        
-        // arruma u e sua mãe (a mãe de p)
-        transplante(p, u);
+    size_t memoria() const {
+        return sizeof(*this) + bits.size() * sizeof(uint64_t);
+    }
+};
 
-        // move p para a esquerda de u, e o filho esquerdo de u para a direita de p
-        p->mae = u;
-        p->dir = u->esq;
-        u->esq = p;
-        
-        if (p->dir) { 
-            p->dir->mae = p;
-        };
+/**
+ * @class ResultadoLote
+ * @brief Resultado da aplicação de um lote de inserções e remoções.
+ *
+ * @details Cada vetor guarda os códigos em ordem crescente.
+ */
+struct ResultadoLote
+{
+    std::vector<int> inseridos;
+    std::vector<int> presentes;
+    std::vector<int> removidos;
+    std::vector<int> ausentes;
+};
 
-        // atualiza alturas
-        p->atualiza_altura();
-        u->atualiza_altura();
-    };
+/**
+ * @class Diferenca
+ * @brief Diferença entre duas cópias de um inventário.
+ *
+ * @details Cada vetor guarda os códigos em ordem crescente, um por ocorrência a mais ou a menos.
+ */
+struct Diferenca
+{
+    std::vector<int> adicionados;
+    std::vector<int> removidos;
+};
 
-    /**
-     * @brief Realiza uma rotação dupla à direita em um nó específico.
-     * 
-     * @param p Ponteiro para o nó a ser rotacionado.
-     */
-    void rotacao_dupla_dir(No *p) {
-        rotacao_esq(p->esq);
-        rotacao_dir(p);
-    };
+/**
+ * @class ObservadorArvore
+ * @brief Interface de quem acompanha as mudanças de uma árvore (por exemplo, uma visão materializada).
+ *
+ * @details A árvore avisa cada código que passou a ter mais uma ocorrência ou uma a menos, em lotes quando a mudança veio de um lote. A origem é o número informado no registro, para que um observador possa acompanhar várias árvores.
+ */
+class ObservadorArvore
+{
+public:
+
+    virtual ~ObservadorArvore() {}
 
     /**
-     * @brief Realiza uma rotação dupla à esquerda em um nó específico.
-     * 
-     * @param p Ponteiro para o nó a ser rotacionado.
+     * @brief Avisa que códigos foram inseridos (uma ocorrência de cada).
+     * @param origem O número de registro da árvore.
+     * @param codigos Os códigos.
+     * @param n O número de códigos.
      */
-    void rotacao_dupla_esq(No *p) {
-        rotacao_dir(p->dir);
-        rotacao_esq(p);
-    };
+    virtual void inseridos(int origem, const int *codigos, size_t n) = 0;
 
     /**
-     * @brief Une duas árvores AVL.
-     *
-     * @param x Ponteiro para o nó raiz da árvore a ser unida.
-     * @param destino Referência para a árvore AVL onde o resultado será armazenado.
+     * @brief Avisa que códigos foram removidos (uma ocorrência de cada).
+     * @param origem O número de registro da árvore.
+     * @param codigos Os códigos.
+     * @param n O número de códigos.
      */
-    void uniao(No *x, AVL &destino)
-    {
-        if (x != nullptr)
-        {
-            // Insere o código do nó atual na árvore de destino
-            destino.insere(x->codigo);
-            // Chama recursivamente para o filho esquerdo e direito
-            uniao(x->esq, destino);
-            uniao(x->dir, destino);
-        }
-    };
+    virtual void removidos(int origem, const int *codigos, size_t n) = 0;
+};
 
+/**
+ * @class BalanceamentoAVL
+ * @brief Política de balanceamento AVL: as alturas das subárvores irmãs diferem de no máximo 1.
+ *
+ * @details O campo `altura` dos nós guarda a altura da subárvore. Uma remoção pode exigir rotações em todos os níveis até a raiz.
+ */
+struct BalanceamentoAVL
+{
     /**
-     * @brief Intersecciona duas árvores AVL e armazena o resultado em uma terceira árvore.
-     * 
-     * @param x Ponteiro para o nó raiz da primeira árvore.
-     * @param T2 Referência para a segunda árvore AVL.
-     * @param T3 Referência para a árvore AVL onde o resultado será armazenado.
+     * @brief Rebalanceia a árvore após a inserção de uma folha.
+     * @param T A árvore.
+     * @param z Ponteiro para a folha inserida (não é a raiz).
+     * @return Nó a partir do qual os resumos dos ancestrais ainda precisam ser refeitos.
      */
-    void intersecao(No *x, AVL &T2, AVL &T3) {
-        if (x != nullptr) {
-            if (T2.busca(x->codigo) != nullptr) 
-                T3.insere(x->codigo);
-            
-            intersecao(x->esq, T2, T3);
-            intersecao(x->dir, T2, T3);
-        }
-    };
+    template <typename Arvore>
+    static No *apos_insercao(Arvore &T, No *z) {
+        do { 
+            z = z->mae;
+            z = T.ajusta_balanceamento(z);
+        } while (
+            !z->eh_raiz() and z->bal() != 0
+        );
+
+        // Acima daqui as alturas não mudam
+        return z->mae;
+    }
 
     /**
-     * @brief Busca elementos dentro de um intervalo de chaves.
-     * 
-     * @param x Ponteiro para o nó de onde a busca começa.
-     * @param min O valor mínimo da chave.
-     * @param max O valor máximo da chave.
+     * @brief Rebalanceia a árvore após a retirada de um nó.
+     * @param T A árvore.
+     * @param p Ponteiro para a mãe da posição de onde o nó foi retirado.
+     * @param esq Indica se a posição é o filho esquerdo de p (não usado pela AVL).
+     * @return Nó a partir do qual os resumos dos ancestrais ainda precisam ser refeitos.
      */
-    void busca_intervalo(No *x, int min, int max) {
-        
-        // Verifica se existe um nó
-        if (x == nullptr) {
-            return;
-        }
-
+    template <typename Arvore>
+    static No *apos_remocao(Arvore &T, No *p, bool esq) {
+        (void) esq;
+        p = T.ajusta_balanceamento(p);
         
-        // Verifica se o nó à esquerda está dentro do intervalo
-        if (x->codigo > min) {
-            busca_intervalo(x->esq, min, max);
+        while (!p->eh_raiz() and p->bal() != 1 and p->bal() != -1) { 
+            p = p->mae;
+            p = T.ajusta_balanceamento(p);
         }
 
-        // Percorre nó por nó e verifica se ele está dentro do intervalo, caso esteja, imprime o código
-        if (x->codigo >= min && x->codigo <= max) {
-            x->escreve("\n");
-        }
+        // Acima daqui as alturas não mudam
+        return p->mae;
+    }
 
-        // Verifica se o nó à direita está dentro do intervalo
-        if (x->codigo < max) {
-            busca_intervalo(x->dir, min, max);
+    /**
+     * @brief Rebalanceia uma subárvore avulsa após a junção de um nó em sua espinha.
+     * @param T A árvore.
+     * @param k Ponteiro para o nó juntado, com a altura já calculada.
+     * @return A raiz da subárvore avulsa.
+     */
+    template <typename Arvore>
+    static No *apos_juncao(Arvore &T, No *k) {
+        No *p = k->mae;
+        No *topo = k;
+        while (p != nullptr) {
+            topo = T.ajusta_balanceamento(p);
+            p = topo->mae;
         }
-    };
-    
+        return topo;
+    }
+};
 
-public:
+/**
+ * @class BalanceamentoWAVL
+ * @brief Política de balanceamento WAVL (weak AVL, balanceada por postos).
+ *
+ * @details O campo `altura` dos nós guarda o posto: a diferença de posto entre um nó e cada filho é 1 ou 2, e as folhas têm posto 0 (nós ausentes têm posto -1). Sem remoções a árvore é idêntica a uma AVL; uma remoção faz no máximo duas rotações, e o rebalanceamento amortizado é O(1) por operação.
+ */
+struct BalanceamentoWAVL
+{
     /**
-     * @brief Construtor padrão para a árvore AVL.
+     * @brief Retorna o posto de um nó, ou -1 se ele for nulo.
+     * @param x Ponteiro para o nó.
      */
-    AVL() {
-        raiz = nullptr;
-    };
+    static inline int posto(No *x) {
+        return x ? x->altura : -1;
+    }
 
     /**
-     * @brief Destrutor para a árvore AVL.
+     * @brief Corrige um nó que pode ter o mesmo posto que a mãe (filho-0), promovendo ou girando.
+     * @param T A árvore.
+     * @param x Ponteiro para o nó.
      */
-    ~AVL() {
-        limpa();
-    };
+    template <typename Arvore>
+    static void corrige_filho_zero(Arvore &T, No *x) {
+        No *p = x->mae;
+        while (p != nullptr && p->altura == x->altura) {
+            bool esq = x == p->esq;
+            No *irmao = esq ? p->dir : p->esq;
+
+            // p é 0,1: promove p e continua subindo
+            if (p->altura - posto(irmao) == 1) {
+                p->altura++;
+                x = p;
+                p = p->mae;
+                continue;
+            }
+
+            // p é 0,2: uma rotação simples ou dupla termina o ajuste
+            // (as rotações recalculam alturas; os postos são refeitos em seguida)
+            int r = p->altura;
+            No *w = esq ? x->dir : x->esq;
+            if (x->altura - posto(w) == 2) {
+                if (esq)
+                    T.rotacao_dir(p);
+                else
+                    T.rotacao_esq(p);
+                x->altura = r;
+                p->altura = r - 1;
+            } else {
+                if (esq)
+                    T.rotacao_dupla_dir(p);
+                else
+                    T.rotacao_dupla_esq(p);
+                w->altura = r;
+                x->altura = r - 1;
+                p->altura = r - 1;
+            }
+            return;
+        }
+    }
 
     /**
-     * @brief Construtor de cópia para a árvore AVL.
-     * 
-     * @param outro Referência para a árvore AVL a ser copiada.
+     * @brief Rebalanceia a árvore após a inserção de uma folha.
+     * @param T A árvore.
+     * @param z Ponteiro para a folha inserida (não é a raiz).
+     * @return Nó a partir do qual os resumos dos ancestrais ainda precisam ser refeitos.
      */
-    AVL(const AVL& outro) {
-        copia(outro);
-    };
-
+    template <typename Arvore>
+    static No *apos_insercao(Arvore &T, No *z) {
+        corrige_filho_zero(T, z);
+        return z;
+    }
 
     /**
-     * @brief Operador de atribuição para a árvore AVL.
-     * 
-     * @param outro Referência para a árvore AVL a ser atribuída.
-     * @return Referência para a árvore AVL atribuída.
+     * @brief Rebalanceia a árvore após a retirada de um nó.
+     * @param T A árvore.
+     * @param p Ponteiro para a mãe da posição de onde o nó foi retirado.
+     * @param esq Indica se a posição é o filho esquerdo de p.
+     * @return Nó a partir do qual os resumos dos ancestrais ainda precisam ser refeitos.
      */
-    AVL& operator=(const AVL& outro) {
-        limpa();
-        copia(outro);
-        return *this;
+    template <typename Arvore>
+    static No *apos_remocao(Arvore &T, No *p, bool esq) {
+        No *inicio = p;
+        No *x = esq ? p->esq : p->dir;
+
+        // Folha com posto 1 (2,2): rebaixa
+        if (p->esq == nullptr && p->dir == nullptr && p->altura == 1) {
+            p->altura = 0;
+            x = p;
+            esq = p->eh_esquerdo();
+            p = p->mae;
+        }
+
+        // Enquanto x for um filho-3
+        while (p != nullptr && p->altura - posto(x) == 3) {
+            No *y = esq ? p->dir : p->esq;
+            int rp = p->altura, ry = y->altura;
+
+            if (rp - ry == 2) {
+                // Irmão é filho-2: rebaixa p
+                p->altura--;
+            } else if (ry - posto(y->esq) == 2 && ry - posto(y->dir) == 2) {
+                // Irmão é 2,2: rebaixa p e o irmão
+                p->altura--;
+                y->altura--;
+            } else {
+                // Uma rotação simples ou dupla termina o ajuste
+                No *externo = esq ? y->dir : y->esq;
+                No *interno = esq ? y->esq : y->dir;
+                if (ry - posto(externo) == 1) {
+                    if (esq)
+                        T.rotacao_esq(p);
+                    else
+                        T.rotacao_dir(p);
+                    y->altura = ry + 1;
+                    p->altura = (p->esq == nullptr && p->dir == nullptr) ? rp - 2 : rp - 1;
+                } else {
+                    int ri = interno->altura;
+                    if (esq)
+                        T.rotacao_dupla_esq(p);
+                    else
+                        T.rotacao_dupla_dir(p);
+                    interno->altura = ri + 2;
+                    y->altura = ry - 1;
+                    p->altura = rp - 2;
+                }
+                break;
+            }
+
+            x = p;
+            esq = p->eh_esquerdo();
+            p = p->mae;
+        }
+        return inicio;
+    }
+
+    /**
+     * @brief Rebalanceia uma subárvore avulsa após a junção de um nó em sua espinha.
+     * @param T A árvore.
+     * @param k Ponteiro para o nó juntado, com o posto já calculado.
+     * @return A raiz da subárvore avulsa.
+     */
+    template <typename Arvore>
+    static No *apos_juncao(Arvore &T, No *k) {
+        corrige_filho_zero(T, k);
+
+        // Os postos acima já estão corretos, mas os resumos não
+        No *x = k;
+        while (x->mae != nullptr) {
+            x = x->mae;
+            x->atualiza_resumo();
+        }
+        return x;
+    }
+};
+
+/**
+ * @class ArvoreBalanceada
+ * @brief Classe que representa uma árvore binária de busca auto-balanceada, com a política de balanceamento escolhida em tempo de compilação.
+ * 
+ * @details A árvore mantém seu balanceamento realizando rotações durante inserções e remoções. Isso garante que a árvore permaneça balanceada, proporcionando complexidade de tempo O(log n) para operações de busca, inserção e remoção. A política (BalanceamentoAVL ou BalanceamentoWAVL) decide como rebalancear após cada inserção, remoção e junção; `AVL` e `WAVL` são os nomes das duas instâncias.
+ */
+template <typename Politica>
+class ArvoreBalanceada
+{
+    // A política de balanceamento usa as rotações e o ajuste de alturas
+    friend Politica;
+
+private:
+    
+    No *raiz; 
+    IndiceHash *indice; // Índice hash opcional para buscas exatas
+    FiltroBloom *filtro; // Filtro de Bloom opcional para descartar códigos ausentes
+    unsigned long versao; // Incrementada sempre que nós são liberados
+    long long rotacoes; // Rotações simples realizadas (uma dupla conta como duas)
+    std::vector<std::pair<ObservadorArvore *, int> > observadores; // Avisados a cada código inserido ou removido
+    No *regiao; // Região contígua criada por compacta(), ou nullptr
+    size_t regiao_tamanho, regiao_vivos; // Nós na região e quantos ainda estão na árvore
+    long long alteracoes; // Códigos inseridos ou removidos desde a última compactação
+
+    /**
+     * @brief Libera um nó retirado da árvore, seja ele alocado sozinho ou parte da região compactada.
+     * @param x Ponteiro para o nó.
+     */
+    void libera(No *x) {
+        if (regiao != nullptr && x >= regiao && x < regiao + regiao_tamanho) {
+            // A região só é devolvida quando o último nó dela sai da árvore
+            x->~No();
+            if (--regiao_vivos == 0) {
+                ::operator delete(regiao);
+                regiao = nullptr;
+                regiao_tamanho = 0;
+            }
+            return;
+        }
+        delete x;
     };
 
     /**
-     * @brief Obtém o nó raiz da árvore AVL.
+     * @brief Acrescenta a uma ordem os nós de uma subárvore, truncada em h níveis, no layout de van Emde Boas.
      * 
-     * @return Ponteiro para o nó raiz.
+     * @details A subárvore é cortada ao meio pela altura: a metade de cima é disposta primeiro e, em seguida, cada subárvore pendurada nela, recursivamente. Toda subárvore de altura h fica em O(h) linhas de cache contíguas, qualquer que seja o tamanho da linha.
+     * @param x Raiz da subárvore.
+     * @param h Número de níveis.
+     * @param ordem Recebe os nós.
+     * @param fronteira Recebe as raízes das subárvores logo abaixo do corte.
      */
-    No *get_raiz() {
-        return raiz;
+    static void ordem_veb(No *x, int h, std::vector<No *> &ordem, std::vector<No *> &fronteira) {
+        if (x == nullptr)
+            return;
+        if (h <= 1) {
+            ordem.push_back(x);
+            if (x->esq) fronteira.push_back(x->esq);
+            if (x->dir) fronteira.push_back(x->dir);
+            return;
+        }
+
+        int topo = h / 2;
+        std::vector<No *> meio;
+        ordem_veb(x, topo, ordem, meio);
+        for (size_t i = 0; i < meio.size(); i++)
+            ordem_veb(meio[i], h - topo, ordem, fronteira);
+    };
+
+    /**
+     * @brief Avisa os observadores de que códigos foram inseridos ou removidos.
+     * @param inseriu true para inserções, false para remoções.
+     * @param codigos Os códigos.
+     * @param n O número de códigos.
+     */
+    void avisa(bool inseriu, const int *codigos, size_t n) {
+        alteracoes += n;
+        if (n == 0)
+            return;
+        for (size_t i = 0; i < observadores.size(); i++) {
+            if (inseriu)
+                observadores[i].first->inseridos(observadores[i].second, codigos, n);
+            else
+                observadores[i].first->removidos(observadores[i].second, codigos, n);
+        }
+    };
+
+    /**
+     * @brief Avisa os observadores de que todos os códigos atuais foram inseridos ou removidos.
+     * @param inseriu true para inserções, false para remoções.
+     */
+    void avisa_todos(bool inseriu) {
+        if (observadores.empty())
+            return;
+        std::vector<int> codigos;
+        em_ordem(raiz, codigos);
+        avisa(inseriu, codigos.data(), codigos.size());
+    };
+
+    /**
+     * @brief Sobe a partir de um nó até a menor subárvore que pode conter uma chave.
+     * 
+     * @details Se k é maior que a chave de y, os ancestrais alcançados por um filho direito são menores que k e não limitam a busca; a subida para no primeiro ancestral alcançado por um filho esquerdo cuja chave é maior que k. O caso de k menor é simétrico. Para chaves próximas de y, a subida é curta.
+     * @param y Ponteiro para o nó de partida.
+     * @param k A chave procurada.
+     * @param limite Recebe o ancestral que limita a subárvore do lado de k (teto se k for maior que a chave de y, piso se for menor), ou nullptr.
+     * @return Ponteiro para a raiz da subárvore onde a busca deve continuar.
+     */
+    No *sobe(No *y, int k, No *&limite) {
+        if (k > y->codigo) {
+            while (y->mae != nullptr && (y->eh_direito() || y->mae->codigo <= k))
+                y = y->mae;
+        } else if (k < y->codigo) {
+            while (y->mae != nullptr && (y->eh_esquerdo() || y->mae->codigo >= k))
+                y = y->mae;
+        }
+        limite = y->mae;
+        return y;
+    };
+
+    /**
+     * @brief Desce por uma subárvore buscando a maior chave menor ou igual a k.
+     * 
+     * @param x Ponteiro para a raiz da subárvore.
+     * @param k A chave de referência.
+     * @param melhor Melhor candidato já conhecido fora da subárvore.
+     * @param ultimo Recebe o último nó visitado.
+     * @return Ponteiro para o piso de k, ou nullptr se não houver.
+     */
+    No *desce_piso(No *x, int k, No *melhor, No *&ultimo) {
+        while (x != nullptr) {
+            ultimo = x;
+            if (x->codigo == k)
+                return x;
+            if (x->codigo < k) {
+                melhor = x;
+                x = x->dir;
+            } else
+                x = x->esq;
+        }
+        return melhor;
+    };
+
+    /**
+     * @brief Desce por uma subárvore buscando a menor chave maior ou igual a k.
+     * 
+     * @param x Ponteiro para a raiz da subárvore.
+     * @param k A chave de referência.
+     * @param melhor Melhor candidato já conhecido fora da subárvore.
+     * @param ultimo Recebe o último nó visitado.
+     * @return Ponteiro para o teto de k, ou nullptr se não houver.
+     */
+    No *desce_teto(No *x, int k, No *melhor, No *&ultimo) {
+        while (x != nullptr) {
+            ultimo = x;
+            if (x->codigo == k)
+                return x;
+            if (x->codigo > k) {
+                melhor = x;
+                x = x->esq;
+            } else
+                x = x->dir;
+        }
+        return melhor;
+    };
+
+    /**
+     * @brief Acrescenta ao filtro de Bloom os códigos de uma subárvore.
+     * 
+     * @param x Ponteiro para a raiz da subárvore.
+     */
+    void filtra(No *x) {
+        for (; x != nullptr; x = x->dir) {
+            filtro->insere(x->codigo);
+            filtra(x->esq);
+        }
+    };
+
+    /**
+     * @brief Reconstrói o filtro de Bloom se ele estiver cheio ou com remoções demais.
+     */
+    void confere_filtro() {
+        if (filtro == nullptr || !filtro->precisa_refazer())
+            return;
+
+        long long n = raiz ? raiz->resumo.itens : 0;
+        filtro->refaz(2 * n);
+        filtra(raiz);
+    };
+
+    /**
+     * @brief Registra no índice hash todos os nós de uma subárvore.
+     * 
+     * @param x Ponteiro para a raiz da subárvore.
+     */
+    void indexa(No *x) {
+        for (; x != nullptr; x = x->dir) {
+            indice->insere(x->codigo, x);
+            indexa(x->esq);
+        }
+    };
+
+    /**
+     * @brief Retira do índice hash um nó que está sendo removido da árvore.
+     * 
+     * @details Se o código tiver outra ocorrência na subárvore indicada, o índice passa a apontar para ela.
+     * @param z Ponteiro para o nó removido.
+     * @param x Subárvore onde procurar outra ocorrência do código.
+     */
+    void desindexa(No *z, No *x) {
+        if (filtro != nullptr)
+            filtro->conta_remocao();
+
+        if (indice == nullptr || indice->busca(z->codigo) != z)
+            return;
+
+        indice->remove(z->codigo);
+        No *outro = busca(x, z->codigo);
+        if (outro != nullptr)
+            indice->insere(outro->codigo, outro);
+    };
+
+    /**
+     * @brief Insere um nó na árvore AVL.
+     * 
+     * @param z Ponteiro para o nó a ser inserido.
+     */
+    void insere(No *z) {
+        
+        if (indice != nullptr)
+            indice->insere(z->codigo, z);
+        if (filtro != nullptr)
+            filtro->insere(z->codigo);
+
+        // Auxiliares
+        No *y = nullptr;
+        No *x = raiz;
+
+
+        while (x != nullptr) {
+            
+            // Aponta para o nó atual
+            y = x;
+
+            // Verifica se z é menor que a raiz
+            if (z->codigo < x->codigo) 
+                x = x->esq;
+            else 
+                x = x->dir;
+        }
+
+        // Definição da mãe de z
+        z->mae = y;
+
+        // Se a árvore estiver vazia, z é a raiz
+        if (y == nullptr) 
+            raiz = z;
+        else 
+            // Verifica se z é menor que o auxiliar
+            if (z->codigo < y->codigo) 
+                y->esq = z;
+            else 
+                y->dir = z;
+
+        // Verifica se z é raiz
+        if (z->eh_raiz())
+            return;
+        
+        // Ajusta o balanceamento da árvore e, acima dele, os resumos
+        atualiza_resumos(Politica::apos_insercao(*this, z));
+        confere_filtro();
+    };
+
+    /**
+     * @brief Refaz os resumos de um nó e de todos os seus ancestrais.
+     * 
+     * @param x Ponteiro para o nó de onde a atualização começa.
+     */
+    void atualiza_resumos(No *x) {
+        for (; x != nullptr; x = x->mae)
+            x->atualiza_resumo();
     };
 
     /**
      * @brief Busca um nó com uma chave específica na árvore AVL.
      * 
+     * @param x Ponteiro para o nó de onde a busca começa.
      * @param k A chave a ser buscada.
      * @return Ponteiro para o nó com a chave especificada, ou nullptr se não encontrado.
      */
-    No *busca(int k) {
-        return busca(raiz, k);
+    No *busca(No *x, int k) {
+        // Caso o nó inicial seja nulo ou a chave seja igual à chave do nó
+        if (x == nullptr || x->codigo == k)
+            return x;
+        // Caso a chave seja menor que a chave do nó, busca à esquerda
+        if (k < x->codigo) 
+            return busca(x->esq, k);
+        else
+            return busca(x->dir, k);
     };
 
     /**
-     * @brief Encontra o nó com a chave mínima na árvore AVL.
+     * @brief Encontra o nó com a menor chave a partir de um nó específico.
      * 
+     * @param x Ponteiro para o nó de onde a busca começa.
      * @return Ponteiro para o nó com a chave mínima.
      */
-    No *minimo() {
-        return minimo(raiz);
+    No *minimo(No *x) {
+        // Enquanto houver um nó à esquerda, o nó atual é substituído pelo filho esquerdo
+        while (x->esq != nullptr) 
+            x = x->esq;
+        return x;
     };
 
     /**
-     * @brief Encontra o nó com a chave máxima na árvore AVL.
+     * @brief Encontra o nó com a maior chave a partir de um nó específico.
      * 
+     * @param x Ponteiro para o nó de onde a busca começa.
      * @return Ponteiro para o nó com a chave máxima.
      */
-    No *maximo() {
-        return maximo(raiz);
+    No *maximo(No *x) {
+        // Enquanto houver um nó à direita, o nó atual é substituído pelo filho direito
+        while (x->dir != nullptr) 
+            x = x->dir;
+        return x;
     };
 
     /**
-     * @brief Encontra o sucessor de um nó específico.
+     * @brief Transplanta uma subárvore enraizada no nó v para a posição do nó u.
      * 
-     * @param x Ponteiro para o nó cujo sucessor será encontrado.
-     * @return Ponteiro para o nó sucessor.
+     * @param u Ponteiro para o nó a ser substituído.
+     * @param v Ponteiro para o nó que substituirá u.
      */
-    No *sucessor(No *x) {
-        if (x->dir != nullptr) 
-            return minimo(x->dir);
+    void transplante(No *u, No *v) {
         
-        No *y = x->mae;
-        while (y != nullptr && x == y->dir) {
-            x = y;
-            y = y->mae;
+        // Se u não tem mãe, é a raiz da árvore ou de uma subárvore avulsa
+        if (u->eh_raiz()) {
+            if (u == raiz)
+                raiz = v;
         }
-        return y;
+        else if (u->eh_esquerdo()) 
+            u->mae->esq = v;
+        else 
+            u->mae->dir = v;
+        
+        // Se houver um nó v
+        if (v != nullptr) 
+            // O nó v recebe a mãe do nó u
+            v->mae = u->mae;
     };
 
-    /**
-     * @brief Encontra o predecessor de um nó específico.
-     * 
-     * @param x Ponteiro para o nó cujo predecessor será encontrado.
-     * @return Ponteiro para o nó predecessor.
-     */
-    No *predecessor(No *x) {
-        if (x->esq != nullptr) 
-            return maximo(x->esq);
-        
-        No *y = x->mae;
-        while (y != nullptr && x == y->esq) {
-            x = y;
-            y = y->mae;
+    /**
+     * @brief Ajusta o balanceamento da árvore AVL após inserção ou remoção.
+     * 
+     * @param p Ponteiro para o nó de onde o ajuste de balanceamento começa.
+     * @return Ponteiro para o nó após o ajuste de balanceamento.
+     */
+    No *ajusta_balanceamento(No *p) {
+        
+        // Atualiza a altura do nó
+        p->atualiza_altura();
+        
+        // Obtém o balanceamento do nó
+        int balance = p->bal();
+
+        // Caso 1: Se o balanceamento de p for 2, o nó está desbalanceado para a esquerda | Rotação à direita ou dupla à direita.
+        if (balance == 2) {
+
+            // Se o fator de balanceamento do filho esquerdo for maior ou igual a zero
+            if (p->esq->bal() >= 0) { 
+                
+                // Caso 1.1: Rotação à direita  
+                rotacao_dir(p);
+
+            } else { // Se o fator de balanceamento do filho esquerdo for menor que zero
+                
+                // Caso 1.2: Rotação dupla direita
+                rotacao_dupla_dir(p);
+
+            }
+            
+            // Atualiza o nó mãe
+            p = p->mae;
+
+        } else
+            
+            // Caso 2: Se o balanceamento for -2, o nó está desbalanceado para a direita | Rotação à esquerda ou dupla à esquerda.
+            if (balance == -2) {
+                
+                // Se o fator de balanceamento do filho direito for menor ou igual a zero
+                if (p->dir->bal() <= 0) {
+
+                    // Caso 2.1: Rotação à esquerda
+                    rotacao_esq(p);
+                
+                } else { // Se o fator de balanceamento do filho direito for maior que zero
+                    
+                    // Caso 2.2: Rotação dupla esquerda
+                    rotacao_dupla_esq(p);
+                }
+                // Atualiza o nó mãe
+                p = p->mae;
+            }
+        
+        // Retorna o nó após o ajuste de balanceamento
+        return p;
+    };
+
+    /**
+     * @brief Remove um nó da árvore AVL.
+     * 
+     * @param z Ponteiro para o nó a ser removido.
+     */
+    void remove(No *z) {
+        
+        
+        No *p = nullptr;
+        bool esq = false; // Lado de p de onde o nó foi retirado
+        
+        if (z->esq == nullptr) { 
+
+            p = z->mae; 
+            esq = z->eh_esquerdo();
+            transplante(z, z->dir);
+        }
+        else {
+            
+            if (z->dir == nullptr) { 
+                p = z->mae; 
+                esq = z->eh_esquerdo();
+                transplante(z, z->esq);
+            }
+            else { 
+                No *y = minimo(z->dir);
+            
+                if (y->mae != z) { 
+                    p = y->mae; 
+                    esq = true;
+                    transplante(y, y->dir); 
+                    y->dir = z->dir;
+                    y->dir->mae = y;
+                }
+            
+                transplante(z, y); // (a)
+                y->esq = z->esq;
+                y->esq->mae = y;
+                // y ocupa o lugar de z: a altura só muda no ajuste a partir de p
+                y->altura = z->altura;
+
+                if (p == nullptr) 
+                    p = y;
+            }
+        }
+
+        
+        if (p == NULL)
+            return;
+        
+        // Ajusta o balanceamento da árvore e, acima dele, os resumos
+        atualiza_resumos(Politica::apos_remocao(*this, p, esq));
+    };
+
+    /**
+     * @brief Limpa a árvore AVL a partir de um nó específico.
+     * 
+     * @param x Ponteiro para o nó de onde a limpeza começa.
+     */
+    void limpa(No *x) {
+        if (x == NULL)
+            return;
+
+        limpa(x->esq);
+        limpa(x->dir);
+        libera(x);
+    };
+
+    /**
+     * @brief Copia uma árvore AVL para a árvore atual a partir da raiz.
+     * 
+     * @param T Referência para a árvore AVL a ser copiada.
+     */
+    void copia(const ArvoreBalanceada& T) {
+        if (T.raiz == nullptr)
+            raiz = nullptr;
+        else {
+            raiz = new No(*T.raiz);
+            raiz->mae = raiz->esq = raiz->dir = nullptr;
+            copia(raiz, T.raiz);
+        }
+    };
+
+    /**
+     * @brief Copia uma subárvore de um nó de origem para um nó de destino.
+     * 
+     * @param dest Ponteiro para o nó de destino.
+     * @param orig Ponteiro para o nó de origem.
+     */
+    void copia(No *dest, No *orig) {
+        if (orig->esq) {
+            dest->esq = new No(*orig->esq);
+            dest->esq->mae = dest;
+            dest->esq->esq = dest->esq->dir = nullptr;
+            copia(dest->esq, orig->esq);
+        }
+        
+        if (orig->dir) {
+            dest->dir = new No(*orig->dir);
+            dest->dir->mae = dest;
+            dest->dir->esq = dest->dir->dir = nullptr;
+            copia(dest->dir, orig->dir);
+        }
+    };
+
+    /**
+     * @brief Constrói uma subárvore perfeitamente balanceada a partir de um vetor ordenado.
+     * 
+     * @param v Vetor ordenado de códigos.
+     * @param ini Índice do primeiro código da subárvore.
+     * @param fim Índice após o último código da subárvore.
+     * @param mae Ponteiro para a mãe da subárvore.
+     * @param niveis_paralelos Número de níveis em que as duas metades são construídas em threads separadas.
+     * @return Ponteiro para a raiz da subárvore.
+     */
+    static No *constroi(const int *v, long ini, long fim, No *mae, int niveis_paralelos) {
+        if (ini >= fim)
+            return nullptr;
+
+        long meio = ini + (fim - ini) / 2;
+        No *x = new No(v[meio]);
+        x->mae = mae;
+
+        if (niveis_paralelos > 0 && fim - ini > 4096) {
+            // Metade esquerda em outra thread, metade direita nesta
+            std::thread t([&]() {
+                x->esq = constroi(v, ini, meio, x, niveis_paralelos - 1);
+            });
+            x->dir = constroi(v, meio + 1, fim, x, niveis_paralelos - 1);
+            t.join();
+        } else {
+            x->esq = constroi(v, ini, meio, x, 0);
+            x->dir = constroi(v, meio + 1, fim, x, 0);
+        }
+
+        x->atualiza_altura();
+        return x;
+    };
+
+    /**
+     * @brief Retorna a altura de uma subárvore, ou -1 se ela for vazia.
+     * 
+     * @param x Ponteiro para a raiz da subárvore.
+     */
+    static inline int altura(No *x) {
+        return x ? x->altura : -1;
+    };
+
+    /**
+     * @brief Separa um nó de seus filhos, tornando-os raízes de subárvores avulsas.
+     * 
+     * @param x Ponteiro para o nó a ser separado (deve ser uma raiz).
+     * @param esq Recebe a subárvore esquerda.
+     * @param dir Recebe a subárvore direita.
+     */
+    static void expoe(No *x, No *&esq, No *&dir) {
+        esq = x->esq;
+        dir = x->dir;
+        if (esq) esq->mae = nullptr;
+        if (dir) dir->mae = nullptr;
+        x->esq = x->dir = nullptr;
+        x->altura = 0;
+    };
+
+    /**
+     * @brief Junta duas subárvores avulsas através de um nó intermediário.
+     * 
+     * @details Todas as chaves de l devem ser menores ou iguais à de k, e as de r maiores ou iguais. O nó k é pendurado na espinha da subárvore mais alta, na altura da mais baixa, e o balanceamento é ajustado apenas nesse caminho, em O(|altura(l) - altura(r)| + 1).
+     * @param l Raiz da subárvore esquerda (pode ser nula).
+     * @param k Nó intermediário, sem filhos.
+     * @param r Raiz da subárvore direita (pode ser nula).
+     * @return Raiz da subárvore resultante.
+     */
+    No *junta(No *l, No *k, No *r) {
+        int hl = altura(l), hr = altura(r);
+        k->mae = nullptr;
+
+        if (hl <= hr + 1 && hr <= hl + 1) {
+            k->esq = l;
+            k->dir = r;
+            if (l) l->mae = k;
+            if (r) r->mae = k;
+            k->atualiza_altura();
+            return k;
+        }
+
+        // Desce pela espinha da subárvore mais alta até a altura da mais baixa
+        No *p = nullptr;
+        No *c = hl > hr ? l : r;
+        int alvo = (hl > hr ? hr : hl) + 1;
+        while (altura(c) > alvo) {
+            p = c;
+            c = hl > hr ? c->dir : c->esq;
+        }
+
+        if (hl > hr) {
+            k->esq = c;
+            k->dir = r;
+            if (r) r->mae = k;
+            p->dir = k;
+        } else {
+            k->esq = l;
+            k->dir = c;
+            if (l) l->mae = k;
+            p->esq = k;
+        }
+        if (c) c->mae = k;
+        k->mae = p;
+        k->atualiza_altura();
+
+        // Ajusta o balanceamento de p até a raiz da subárvore
+        return Politica::apos_juncao(*this, k);
+    };
+
+    /**
+     * @brief Junta duas subárvores avulsas sem nó intermediário.
+     * 
+     * @param l Raiz da subárvore esquerda (pode ser nula).
+     * @param r Raiz da subárvore direita (pode ser nula).
+     * @return Raiz da subárvore resultante.
+     */
+    No *junta(No *l, No *r) {
+        if (l == nullptr)
+            return r;
+        No *m;
+        l = separa_maximo(l, m);
+        return junta(l, m, r);
+    };
+
+    /**
+     * @brief Retira o nó de maior chave de uma subárvore avulsa.
+     * 
+     * @param x Raiz da subárvore (não nula).
+     * @param m Recebe o nó retirado, sem filhos.
+     * @return Raiz da subárvore restante.
+     */
+    No *separa_maximo(No *x, No *&m) {
+        No *l, *r;
+        expoe(x, l, r);
+        if (r == nullptr) {
+            m = x;
+            return l;
+        }
+        r = separa_maximo(r, m);
+        return junta(l, x, r);
+    };
+
+    /**
+     * @brief Separa uma subárvore avulsa em duas pela chave k.
+     * 
+     * @details Cada nó do caminho da raiz até k é exposto e juntado de volta ao lado a que pertence; como as alturas das subárvores juntadas crescem ao longo do caminho, o custo total é O(log n).
+     * @param x Raiz da subárvore (pode ser nula).
+     * @param k A chave de separação.
+     * @param inclui_k Se true, as chaves iguais a k vão para a esquerda; senão, para a direita.
+     * @param l Recebe a subárvore das chaves menores que k (ou menores ou iguais).
+     * @param r Recebe a subárvore das demais chaves.
+     */
+    void separa(No *x, int k, bool inclui_k, No *&l, No *&r) {
+        if (x == nullptr) {
+            l = r = nullptr;
+            return;
+        }
+
+        No *a, *b, *m;
+        expoe(x, a, b);
+        if (x->codigo < k || (inclui_k && x->codigo == k)) {
+            separa(b, k, inclui_k, m, r);
+            l = junta(a, x, m);
+        } else {
+            separa(a, k, inclui_k, l, m);
+            r = junta(m, x, b);
+        }
+    };
+
+    /**
+     * @brief Libera uma subárvore avulsa cujos códigos saíram da árvore, retirando-os do índice hash.
+     * 
+     * @param x Raiz da subárvore (pode ser nula).
+     */
+    void descarta(No *x) {
+        while (x != nullptr) {
+            descarta(x->esq);
+            No *d = x->dir;
+            desindexa(x, nullptr);
+            libera(x);
+            x = d;
+        }
+    };
+
+    /**
+     * @brief Ordena um vetor e retira dele as repetições.
+     * 
+     * @param v Vetor a ser ordenado.
+     * @param repetidos Recebe, em ordem, as ocorrências retiradas.
+     */
+    static void ordena_sem_repeticoes(std::vector<int> &v, std::vector<int> &repetidos) {
+        std::sort(v.begin(), v.end());
+        size_t n = 0;
+        for (size_t i = 0; i < v.size(); i++) {
+            if (n > 0 && v[i] == v[n - 1])
+                repetidos.push_back(v[i]);
+            else
+                v[n++] = v[i];
+        }
+        v.resize(n);
+    };
+
+    /**
+     * @brief Insere um lote ordenado e sem repetições em uma subárvore avulsa.
+     * 
+     * @details O lote é dividido pela chave da raiz; cada parte é inserida recursivamente em um dos filhos e o resultado é juntado de volta, com custo O(m log(n/m + 1)) para m códigos em uma subárvore de n nós.
+     * @param x Raiz da subárvore (pode ser nula).
+     * @param v Início do lote.
+     * @param n Tamanho do lote.
+     * @param resultado Recebe os códigos inseridos e os já presentes.
+     * @return Raiz da subárvore resultante.
+     */
+    No *insere_lote(No *x, const int *v, long n, ResultadoLote &resultado) {
+        if (n == 0)
+            return x;
+        if (x == nullptr) {
+            resultado.inseridos.insert(resultado.inseridos.end(), v, v + n);
+            x = constroi(v, 0, n, nullptr, 0);
+            if (indice != nullptr)
+                indexa(x);
+            if (filtro != nullptr)
+                filtra(x);
+            return x;
+        }
+
+        No *l, *r;
+        expoe(x, l, r);
+        long i = std::lower_bound(v, v + n, x->codigo) - v;
+        long j = (i < n && v[i] == x->codigo) ? i + 1 : i;
+
+        l = insere_lote(l, v, i, resultado);
+        if (j > i)
+            resultado.presentes.push_back(x->codigo);
+        r = insere_lote(r, v + j, n - j, resultado);
+        return junta(l, x, r);
+    };
+
+    /**
+     * @brief Remove um lote ordenado e sem repetições de uma subárvore avulsa.
+     * 
+     * @param x Raiz da subárvore (pode ser nula).
+     * @param v Início do lote.
+     * @param n Tamanho do lote.
+     * @param resultado Recebe os códigos removidos e os ausentes.
+     * @return Raiz da subárvore resultante.
+     */
+    No *remove_lote(No *x, const int *v, long n, ResultadoLote &resultado) {
+        if (n == 0)
+            return x;
+        if (x == nullptr) {
+            resultado.ausentes.insert(resultado.ausentes.end(), v, v + n);
+            return nullptr;
+        }
+
+        No *l, *r;
+        expoe(x, l, r);
+        long i = std::lower_bound(v, v + n, x->codigo) - v;
+        bool achou = i < n && v[i] == x->codigo;
+        long j = achou ? i + 1 : i;
+
+        l = remove_lote(l, v, i, resultado);
+        if (achou)
+            resultado.removidos.push_back(x->codigo);
+        r = remove_lote(r, v + j, n - j, resultado);
+
+        if (!achou)
+            return junta(l, x, r);
+
+        No *y = junta(l, r);
+        desindexa(x, y);
+        libera(x);
+        return y;
+    };
+
+    /**
+     * @brief Copia os códigos de uma subárvore, em ordem, para um vetor.
+     * 
+     * @param x Ponteiro para a raiz da subárvore.
+     * @param v Vetor de destino.
+     */
+    void em_ordem(No *x, std::vector<int> &v) {
+        while (x != nullptr) {
+            em_ordem(x->esq, v);
+            v.push_back(x->codigo);
+            x = x->dir;
+        }
+    };
+
+    /**
+     * @brief Realiza uma rotação à direita em um nó específico.
+     * 
+     * @param p Ponteiro para o nó a ser rotacionado.
+     */
+    void rotacao_dir(No *p) {
+        
+        No *u = p->esq;
+        rotacoes++;
+        
+        // arruma u e sua mãe (a mãe de p)
+        transplante(p, u);
+        
+        // move p para a direita de u, e o filho direito de u para a esquerda de p
+        p->mae = u;
+        p->esq = u->dir;
+        u->dir = p;
+        
+        if (p->esq) {
+            // arruma a mãe do filho esquerdo de p
+            p->esq->mae = p;
+        }
+
+        // atualiza alturas
+        p->atualiza_altura();
+        u->atualiza_altura();
+    };
+
+    /**
+     * @brief Realiza uma rotação à esquerda em um nó específico.
+     * 
+     * @param p Ponteiro para o nó a ser rotacionado.
+     */
+    void rotacao_esq(No *p) {
+        
+        No *u = p->dir;
+        rotacoes++;
+        
+        // arruma u e sua mãe (a mãe de p)
+        transplante(p, u);
+
+        // move p para a esquerda de u, e o filho esquerdo de u para a direita de p
+        p->mae = u;
+        p->dir = u->esq;
+        u->esq = p;
+        
+        if (p->dir) { 
+            p->dir->mae = p;
+        };
+
+        // atualiza alturas
+        p->atualiza_altura();
+        u->atualiza_altura();
+    };
+
+    /**
+     * @brief Realiza uma rotação dupla à direita em um nó específico.
+     * 
+     * @param p Ponteiro para o nó a ser rotacionado.
+     */
+    void rotacao_dupla_dir(No *p) {
+        rotacao_esq(p->esq);
+        rotacao_dir(p);
+    };
+
+    /**
+     * @brief Realiza uma rotação dupla à esquerda em um nó específico.
+     * 
+     * @param p Ponteiro para o nó a ser rotacionado.
+     */
+    void rotacao_dupla_esq(No *p) {
+        rotacao_dir(p->dir);
+        rotacao_esq(p);
+    };
+
+    /**
+     * @brief Une duas árvores AVL.
+     *
+     * @param x Ponteiro para o nó raiz da árvore a ser unida.
+     * @param destino Referência para a árvore AVL onde o resultado será armazenado.
+     */
+    void uniao(No *x, ArvoreBalanceada &destino)
+    {
+        if (x != nullptr)
+        {
+            // Insere o código do nó atual na árvore de destino
+            destino.insere(x->codigo);
+            // Chama recursivamente para o filho esquerdo e direito
+            uniao(x->esq, destino);
+            uniao(x->dir, destino);
+        }
+    };
+
+    /**
+     * @brief Intersecciona duas árvores AVL e armazena o resultado em uma terceira árvore.
+     * 
+     * @param x Ponteiro para o nó raiz da primeira árvore.
+     * @param T2 Referência para a segunda árvore AVL.
+     * @param T3 Referência para a árvore AVL onde o resultado será armazenado.
+     */
+    void intersecao(No *x, ArvoreBalanceada &T2, ArvoreBalanceada &T3) {
+        if (x != nullptr) {
+            // Com o filtro de Bloom de T2 ativo, a maioria dos ausentes é descartada sem descer por T2
+            if (T2.busca(x->codigo) != nullptr) 
+                T3.insere(x->codigo);
+            
+            intersecao(x->esq, T2, T3);
+            intersecao(x->dir, T2, T3);
+        }
+    };
+
+    /**
+     * @brief Agrega os atributos dos itens de uma subárvore dentro de um intervalo de chaves.
+     * 
+     * @details Desce até o primeiro nó dentro do intervalo e, a partir dele, soma os resumos das subárvores que ficam inteiramente dentro do intervalo ao longo das duas fronteiras.
+     * @param x Ponteiro para a raiz da subárvore.
+     * @param min O valor mínimo da chave.
+     * @param max O valor máximo da chave.
+     * @return O resumo dos itens do intervalo.
+     */
+    Resumo agrega(No *x, int min, int max) {
+        Resumo r;
+
+        // Desce até o nó onde as fronteiras do intervalo se separam
+        while (x != nullptr && (x->codigo < min || x->codigo > max))
+            x = x->codigo < min ? x->dir : x->esq;
+
+        if (x != nullptr) {
+            r.acumula(Resumo(x->codigo, x->estoque, x->valor));
+            agrega_a_partir(x->esq, min, r);
+            agrega_ate(x->dir, max, r);
+        }
+        return r;
+    };
+
+    /**
+     * @brief Acrescenta a um vetor, em ordem, os códigos de uma subárvore que estão em [min, max].
+     * 
+     * @param x Ponteiro para a raiz da subárvore.
+     * @param min O valor mínimo da chave.
+     * @param max O valor máximo da chave.
+     * @param v Vetor de destino.
+     */
+    void coleta(No *x, int min, int max, std::vector<int> &v) {
+        while (x != nullptr) {
+            if (x->codigo < min) {
+                x = x->dir;
+                continue;
+            }
+            coleta(x->esq, min, max, v);
+            if (x->codigo > max)
+                return;
+            v.push_back(x->codigo);
+            x = x->dir;
+        }
+    };
+
+    /**
+     * @brief Acumula a diferença entre esta árvore e outra no intervalo [min, max].
+     * 
+     * @param x Subárvore desta árvore que contém todos os seus códigos do intervalo.
+     * @param outra A outra árvore.
+     * @param min O valor mínimo da chave.
+     * @param max O valor máximo da chave.
+     * @param d Recebe os códigos adicionados e removidos.
+     */
+    void diferenca(No *x, ArvoreBalanceada &outra, int min, int max, Diferenca &d) {
+        while (x != nullptr && (x->codigo < min || x->codigo > max))
+            x = x->codigo < min ? x->dir : x->esq;
+
+        // Mesmo número de itens e mesmo hash: o intervalo é igual nas duas árvores
+        Resumo a = agrega(x, min, max), b = outra.agrega_intervalo(min, max);
+        if (a.itens == b.itens && a.hash == b.hash)
+            return;
+        if (a.itens == 0) {
+            outra.coleta(outra.raiz, min, max, d.adicionados);
+            return;
+        }
+        if (b.itens == 0) {
+            coleta(x, min, max, d.removidos);
+            return;
+        }
+
+        // Os códigos menores que o do nó estão todos à esquerda dele, e os maiores, à direita
+        int k = x->codigo;
+        if (k > min)
+            diferenca(x->esq, outra, min, k - 1, d);
+        long long aqui = agrega(x, k, k).itens, ali = outra.agrega_intervalo(k, k).itens;
+        for (; aqui > ali; aqui--)
+            d.removidos.push_back(k);
+        for (; ali > aqui; ali--)
+            d.adicionados.push_back(k);
+        if (k < max)
+            diferenca(x->dir, outra, k + 1, max, d);
+    };
+
+    /**
+     * @brief Agrega os itens com código maior ou igual a min em uma subárvore.
+     * 
+     * @param x Ponteiro para a raiz da subárvore.
+     * @param min O valor mínimo da chave.
+     * @param r Resumo onde os itens são acumulados.
+     */
+    void agrega_a_partir(No *x, int min, Resumo &r) {
+        while (x != nullptr) {
+            if (x->codigo >= min) {
+                // x e toda a subárvore direita estão no intervalo
+                r.acumula(Resumo(x->codigo, x->estoque, x->valor));
+                if (x->dir)
+                    r.acumula(x->dir->resumo);
+                x = x->esq;
+            } else
+                x = x->dir;
+        }
+    };
+
+    /**
+     * @brief Agrega os itens com código menor ou igual a max em uma subárvore.
+     * 
+     * @param x Ponteiro para a raiz da subárvore.
+     * @param max O valor máximo da chave.
+     * @param r Resumo onde os itens são acumulados.
+     */
+    void agrega_ate(No *x, int max, Resumo &r) {
+        while (x != nullptr) {
+            if (x->codigo <= max) {
+                // x e toda a subárvore esquerda estão no intervalo
+                r.acumula(Resumo(x->codigo, x->estoque, x->valor));
+                if (x->esq)
+                    r.acumula(x->esq->resumo);
+                x = x->dir;
+            } else
+                x = x->esq;
+        }
+    };
+
+    /**
+     * @brief Busca elementos dentro de um intervalo de chaves.
+     * 
+     * @param x Ponteiro para o nó de onde a busca começa.
+     * @param min O valor mínimo da chave.
+     * @param max O valor máximo da chave.
+     */
+    void busca_intervalo(No *x, int min, int max) {
+        
+        // Verifica se existe um nó
+        if (x == nullptr) {
+            return;
+        }
+
+        
+        // Verifica se o nó à esquerda está dentro do intervalo
+        if (x->codigo > min) {
+            busca_intervalo(x->esq, min, max);
+        }
+
+        // Percorre nó por nó e verifica se ele está dentro do intervalo, caso esteja, imprime o código
+        if (x->codigo >= min && x->codigo <= max) {
+            x->escreve("\n");
+        }
+
+        // Verifica se o nó à direita está dentro do intervalo
+        if (x->codigo < max) {
+            busca_intervalo(x->dir, min, max);
+        }
+    };
+    
+
+public:
+    /**
+     * @brief Construtor padrão para a árvore AVL.
+     */
+    ArvoreBalanceada() {
+        raiz = nullptr;
+        indice = nullptr;
+        filtro = nullptr;
+        versao = 0;
+        rotacoes = 0;
+        regiao = nullptr;
+        regiao_tamanho = regiao_vivos = 0;
+        alteracoes = 0;
+    };
+
+    /**
+     * @brief Destrutor para a árvore AVL.
+     */
+    ~ArvoreBalanceada() {
+        limpa();
+        delete indice;
+        delete filtro;
+    };
+
+    /**
+     * @brief Construtor de cópia para a árvore AVL.
+     * 
+     * @param outro Referência para a árvore AVL a ser copiada.
+     */
+    ArvoreBalanceada(const ArvoreBalanceada& outro) {
+        indice = nullptr;
+        filtro = nullptr;
+        versao = 0;
+        rotacoes = 0;
+        regiao = nullptr;
+        regiao_tamanho = regiao_vivos = 0;
+        alteracoes = 0;
+        copia(outro);
+        if (outro.indice != nullptr)
+            ativa_indice_hash();
+        if (outro.filtro != nullptr)
+            ativa_filtro_bloom();
+    };
+
+
+    /**
+     * @brief Operador de atribuição para a árvore AVL.
+     * 
+     * @param outro Referência para a árvore AVL a ser atribuída.
+     * @return Referência para a árvore AVL atribuída.
+     */
+    ArvoreBalanceada& operator=(const ArvoreBalanceada& outro) {
+        limpa();
+        copia(outro);
+        avisa_todos(true);
+        if (outro.indice != nullptr)
+            ativa_indice_hash();
+        else
+            desativa_indice_hash();
+        if (outro.filtro != nullptr)
+            ativa_filtro_bloom();
+        else
+            desativa_filtro_bloom();
+        return *this;
+    };
+
+    /**
+     * @brief Ativa o índice hash, que passa a responder às buscas exatas com uma única sondagem.
+     * 
+     * @details O índice é mantido junto com a árvore em todas as inserções e remoções. Buscas em intervalo, mínimo, máximo e sucessor continuam usando a árvore.
+     */
+    void ativa_indice_hash() {
+        if (indice == nullptr)
+            indice = new IndiceHash();
+        else
+            indice->limpa();
+        indexa(raiz);
+    };
+
+    /**
+     * @brief Desativa o índice hash, liberando sua memória.
+     */
+    void desativa_indice_hash() {
+        delete indice;
+        indice = nullptr;
+    };
+
+    /**
+     * @brief Retorna a memória ocupada pelo índice hash, em bytes (0 se estiver desativado).
+     */
+    size_t memoria_indice_hash() const {
+        return indice ? indice->memoria() : 0;
+    };
+
+    /**
+     * @brief Ativa o filtro de Bloom, consultado antes de cada busca exata.
+     * 
+     * @details Códigos que o filtro descarta são dados como ausentes sem descer pela árvore. O filtro é mantido nas inserções e reconstruído quando enche ou quando as remoções acumuladas passam de um quarto dos códigos.
+     */
+    void ativa_filtro_bloom() {
+        long long n = raiz ? raiz->resumo.itens : 0;
+        if (filtro == nullptr)
+            filtro = new FiltroBloom(2 * n);
+        else
+            filtro->refaz(2 * n);
+        filtra(raiz);
+    };
+
+    /**
+     * @brief Desativa o filtro de Bloom, liberando sua memória.
+     */
+    void desativa_filtro_bloom() {
+        delete filtro;
+        filtro = nullptr;
+    };
+
+    /**
+     * @brief Retorna o filtro de Bloom, para consulta das estatísticas, ou nullptr se estiver desativado.
+     */
+    const FiltroBloom *get_filtro_bloom() const {
+        return filtro;
+    };
+
+    /**
+     * @brief Retorna a memória ocupada pelos nós da árvore, em bytes.
+     */
+    size_t memoria_nos() const {
+        return raiz ? raiz->resumo.itens * sizeof(No) : 0;
+    };
+
+    /**
+     * @brief Obtém o nó raiz da árvore AVL.
+     * 
+     * @return Ponteiro para o nó raiz.
+     */
+    No *get_raiz() {
+        return raiz;
+    };
+
+    /**
+     * @brief Busca um nó com uma chave específica na árvore AVL.
+     * 
+     * @param k A chave a ser buscada.
+     * @return Ponteiro para o nó com a chave especificada, ou nullptr se não encontrado.
+     */
+    No *busca(int k) {
+        if (filtro != nullptr && !filtro->talvez_contem(k))
+            return nullptr;
+
+        No *x = indice != nullptr ? indice->busca(k) : busca(raiz, k);
+        if (filtro != nullptr && x == nullptr)
+            filtro->registra_falso_positivo();
+        return x;
+    };
+
+    /**
+     * @brief Encontra o nó com a chave mínima na árvore AVL.
+     * 
+     * @return Ponteiro para o nó com a chave mínima.
+     */
+    No *minimo() {
+        return minimo(raiz);
+    };
+
+    /**
+     * @brief Encontra o nó com a chave máxima na árvore AVL.
+     * 
+     * @return Ponteiro para o nó com a chave máxima.
+     */
+    No *maximo() {
+        return maximo(raiz);
+    };
+
+    /**
+     * @brief Retorna a versão da árvore, que muda sempre que nós são liberados.
+     * 
+     * @details Ponteiros para nós obtidos antes de uma mudança de versão podem não ser mais válidos.
+     */
+    unsigned long get_versao() const {
+        return versao;
+    };
+
+    /**
+     * @brief Retorna o número de rotações simples feitas pela árvore (uma rotação dupla conta como duas).
+     */
+    long long get_rotacoes() const {
+        return rotacoes;
+    };
+
+    /**
+     * @brief Registra um observador, avisado a cada código inserido ou removido a partir de agora.
+     * 
+     * @details O observador deve se desregistrar antes de ser destruído. Cópias da árvore não herdam os observadores.
+     * @param observador O observador.
+     * @param origem Número repassado ao observador em cada aviso.
+     */
+    void registra(ObservadorArvore *observador, int origem) {
+        observadores.push_back(std::make_pair(observador, origem));
+    };
+
+    /**
+     * @brief Desregistra um observador.
+     * @param observador O observador.
+     */
+    void desregistra(ObservadorArvore *observador) {
+        for (size_t i = 0; i < observadores.size(); i++) {
+            if (observadores[i].first == observador) {
+                observadores.erase(observadores.begin() + i);
+                i--;
+            }
+        }
+    };
+
+    /**
+     * @brief Muda todos os nós para uma região contígua nova, na ordem de van Emde Boas ou em pré-ordem.
+     * 
+     * @details Depois de muitas inserções e remoções os nós ficam espalhados pela memória na ordem em que foram alocados, e cada passo de uma descida ou de um percurso custa uma falta de cache. A compactação copia os nós para um único bloco, refaz os ponteiros mae/esq/dir e libera os nós antigos; a árvore continua alterável. Ponteiros para nós obtidos antes deixam de valer (os cursores recomeçam da raiz e o índice hash é refeito).
+     * @param veb true para a ordem de van Emde Boas (boa para buscas), false para a pré-ordem (boa para percursos).
+     */
+    void compacta(bool veb = true) {
+        if (raiz == nullptr)
+            return;
+
+        // Ordem dos nós na região nova
+        std::vector<No *> ordem;
+        ordem.reserve(raiz->resumo.itens);
+        if (veb) {
+            std::vector<No *> fronteira;
+            ordem_veb(raiz, raiz->altura + 1, ordem, fronteira);
+        } else {
+            std::vector<No *> pilha(1, raiz);
+            while (!pilha.empty()) {
+                No *x = pilha.back();
+                pilha.pop_back();
+                ordem.push_back(x);
+                if (x->dir) pilha.push_back(x->dir);
+                if (x->esq) pilha.push_back(x->esq);
+            }
+        }
+
+        size_t n = ordem.size();
+        No *nova = static_cast<No *>(::operator new(n * sizeof(No)));
+        for (size_t i = 0; i < n; i++)
+            new (&nova[i]) No(*ordem[i]);
+
+        // O campo mae dos nós antigos passa a apontar para a cópia; os ponteiros das cópias são traduzidos por ele
+        for (size_t i = 0; i < n; i++)
+            ordem[i]->mae = &nova[i];
+        for (size_t i = 0; i < n; i++) {
+            No &x = nova[i];
+            x.mae = x.mae ? x.mae->mae : nullptr;
+            x.esq = x.esq ? x.esq->mae : nullptr;
+            x.dir = x.dir ? x.dir->mae : nullptr;
+        }
+        raiz = &nova[0];
+
+        for (size_t i = 0; i < n; i++)
+            libera(ordem[i]);
+        regiao = nova;
+        regiao_tamanho = regiao_vivos = n;
+        alteracoes = 0;
+        versao++;
+        if (indice != nullptr) {
+            indice->limpa();
+            indexa(raiz);
+        }
+    };
+
+    /**
+     * @brief Indica se a árvore sofreu alterações suficientes desde a última compactação para valer a pena compactá-la.
+     * 
+     * @details Verdadeiro quando o número de códigos inseridos e removidos passa da metade do tamanho atual.
+     */
+    bool precisa_compactar() const {
+        long long n = raiz ? raiz->resumo.itens : 0;
+        return alteracoes > 1024 && alteracoes * 2 > n;
+    };
+
+    /**
+     * @brief Encontra o nó com a maior chave menor ou igual a k.
+     * 
+     * @param k A chave de referência.
+     * @return Ponteiro para o piso de k, ou nullptr se todas as chaves forem maiores.
+     */
+    No *piso(int k) {
+        No *ultimo;
+        return desce_piso(raiz, k, nullptr, ultimo);
+    };
+
+    /**
+     * @brief Encontra o nó com a menor chave maior ou igual a k.
+     * 
+     * @param k A chave de referência.
+     * @return Ponteiro para o teto de k, ou nullptr se todas as chaves forem menores.
+     */
+    No *teto(int k) {
+        No *ultimo;
+        return desce_teto(raiz, k, nullptr, ultimo);
+    };
+
+    /**
+     * @brief Busca uma chave a partir de um nó já visitado (busca com dedo).
+     * 
+     * @details Sobe pelos ancestrais do dedo apenas até a subárvore que pode conter k e desce a partir dela, com custo O(log d) para uma chave a distância d do dedo.
+     * @param dedo Nó de partida (não nulo); recebe o último nó visitado.
+     * @param k A chave a ser buscada.
+     * @return Ponteiro para o nó com a chave especificada, ou nullptr se não encontrado.
+     */
+    No *busca_a_partir(No *&dedo, int k) {
+        No *x = piso_a_partir(dedo, k);
+        return (x != nullptr && x->codigo == k) ? x : nullptr;
+    };
+
+    /**
+     * @brief Encontra o piso de k a partir de um nó já visitado.
+     * 
+     * @param dedo Nó de partida (não nulo); recebe o último nó visitado.
+     * @param k A chave de referência.
+     * @return Ponteiro para o piso de k, ou nullptr se não houver.
+     */
+    No *piso_a_partir(No *&dedo, int k) {
+        No *limite;
+        bool menor = k < dedo->codigo;
+        No *y = sobe(dedo, k, limite);
+        return desce_piso(y, k, menor ? limite : nullptr, dedo);
+    };
+
+    /**
+     * @brief Encontra o teto de k a partir de um nó já visitado.
+     * 
+     * @param dedo Nó de partida (não nulo); recebe o último nó visitado.
+     * @param k A chave de referência.
+     * @return Ponteiro para o teto de k, ou nullptr se não houver.
+     */
+    No *teto_a_partir(No *&dedo, int k) {
+        No *limite;
+        bool maior = k > dedo->codigo;
+        No *y = sobe(dedo, k, limite);
+        return desce_teto(y, k, maior ? limite : nullptr, dedo);
+    };
+
+    /**
+     * @brief Encontra o sucessor de um nó específico.
+     * 
+     * @param x Ponteiro para o nó cujo sucessor será encontrado.
+     * @return Ponteiro para o nó sucessor.
+     */
+    No *sucessor(No *x) {
+        if (x->dir != nullptr) 
+            return minimo(x->dir);
+        
+        No *y = x->mae;
+        while (y != nullptr && x == y->dir) {
+            x = y;
+            y = y->mae;
+        }
+        return y;
+    };
+
+    /**
+     * @brief Encontra o predecessor de um nó específico.
+     * 
+     * @param x Ponteiro para o nó cujo predecessor será encontrado.
+     * @return Ponteiro para o nó predecessor.
+     */
+    No *predecessor(No *x) {
+        if (x->esq != nullptr) 
+            return maximo(x->esq);
+        
+        No *y = x->mae;
+        while (y != nullptr && x == y->esq) {
+            x = y;
+            y = y->mae;
+        }
+        return y;
+    };
+
+    /**
+     * @brief Insere um nó com uma chave específica na árvore AVL.
+     * 
+     * @param codigo A chave do nó a ser inserido.
+     */
+    void insere(int codigo) {
+        No *z = new No(codigo);
+        insere(z);
+        avisa(true, &codigo, 1);
+    };
+
+    /**
+     * @brief Insere um item com seus atributos na árvore AVL.
+     * 
+     * @param codigo A chave do nó a ser inserido.
+     * @param estoque O estoque do item.
+     * @param valor O valor do item.
+     */
+    void insere(int codigo, long long estoque, double valor) {
+        No *z = new No(codigo, estoque, valor);
+        insere(z);
+        avisa(true, &codigo, 1);
+    };
+
+    /**
+     * @brief Altera os atributos de um item, refazendo os resumos dos seus ancestrais.
+     * 
+     * @param codigo A chave do item.
+     * @param estoque O novo estoque do item.
+     * @param valor O novo valor do item.
+     * @return True se o item existe, false caso contrário.
+     */
+    bool define_atributos(int codigo, long long estoque, double valor) {
+        No *x = busca(codigo);
+        if (x == nullptr)
+            return false;
+
+        x->estoque = estoque;
+        x->valor = valor;
+        atualiza_resumos(x);
+        return true;
+    };
+
+    /**
+     * @brief Agrega os atributos dos itens dentro de um intervalo de chaves, em O(log n).
+     * 
+     * @details Desce até o primeiro nó dentro do intervalo e, a partir dele, soma os resumos das subárvores que ficam inteiramente dentro do intervalo ao longo das duas fronteiras.
+     * @param min O valor mínimo da chave.
+     * @param max O valor máximo da chave.
+     * @return O resumo dos itens do intervalo.
+     */
+    Resumo agrega_intervalo(int min, int max) {
+        return agrega(raiz, min, max);
+    };
+
+    /**
+     * @brief Calcula a diferença entre esta árvore e outra cópia do inventário, visitando só as partes que mudaram.
+     * 
+     * @details As duas árvores são comparadas de cima para baixo, seguindo os nós desta. Um intervalo de códigos cujo número de itens e hash coincidem nas duas é pulado sem ser percorrido; os demais são divididos pelo código do nó, e um intervalo vazio de um lado vai inteiro para a diferença. O custo é O(d log² n) para d códigos diferentes, independente do formato de cada árvore.
+     * @param outra A outra cópia.
+     * @return Os códigos que a outra tem a mais (adicionados) e a menos (removidos) que esta.
+     */
+    Diferenca diferenca_rapida(ArvoreBalanceada &outra) {
+        Diferenca d;
+        diferenca(raiz, outra, INT_MIN, INT_MAX, d);
+        return d;
+    };
+
+    /**
+     * @brief Remove um nó com uma chave específica da árvore AVL.
+     * 
+     * @param codigo A chave do nó a ser removido.
+     * @return True se o nó foi removido, false caso contrário.
+     */
+    bool remove(int codigo) {
+        No *z = busca(codigo);
+        if (z == nullptr) 
+            return false;
+        
+        remove(z);
+        desindexa(z, raiz);
+        libera(z);
+        versao++;
+        confere_filtro();
+        avisa(false, &codigo, 1);
+        return true;
+    };
+
+    /**
+     * @brief Remove todos os itens com código no intervalo [min, max].
+     * 
+     * @details A árvore é separada no limite inferior e no superior; a parte do meio é liberada de uma vez, sem rebalanceamentos, e as partes de fora são juntadas de volta. O custo é O(log n + k) para k itens removidos.
+     * @param min O menor código do intervalo.
+     * @param max O maior código do intervalo.
+     * @return O número de itens removidos.
+     */
+    long remove_intervalo(int min, int max) {
+        if (raiz == nullptr || min > max)
+            return 0;
+
+        No *menores, *resto, *meio, *maiores;
+        No *x = raiz;
+        raiz = nullptr;
+        separa(x, min, false, menores, resto);
+        separa(resto, max, true, meio, maiores);
+        raiz = junta(menores, maiores);
+
+        std::vector<int> removidos;
+        em_ordem(meio, removidos);
+        descarta(meio);
+        if (!removidos.empty())
+            versao++;
+        confere_filtro();
+        avisa(false, removidos.data(), removidos.size());
+        return (long) removidos.size();
+    };
+
+    /**
+     * @brief Copia os códigos da árvore, em ordem crescente, para um vetor.
+     * 
+     * @param v Vetor de destino (os códigos são acrescentados ao final).
+     */
+    void em_ordem(std::vector<int> &v) {
+        em_ordem(raiz, v);
+    };
+
+    /**
+     * @brief Carrega um vetor ordenado e sem repetições na árvore, construindo-a já balanceada.
+     * 
+     * @details Se a árvore estiver vazia, ela é construída diretamente, com os níveis superiores construídos em paralelo. Caso contrário, os códigos novos são mesclados aos nós existentes como um lote de inserções.
+     * @param ordenados Vetor ordenado de códigos, sem repetições.
+     * @param threads Número de threads a serem usadas na construção.
+     */
+    void carrega_ordenado(const std::vector<int> &ordenados, int threads = 1) {
+        if (raiz != nullptr) {
+            // Mescla com os nós existentes, preservando seus atributos
+            ResultadoLote resultado;
+            No *x = raiz;
+            raiz = nullptr;
+            raiz = insere_lote(x, ordenados.data(), ordenados.size(), resultado);
+            confere_filtro();
+            avisa(true, resultado.inseridos.data(), resultado.inseridos.size());
+            return;
+        }
+
+        // Número de níveis com construção paralela: log2(threads)
+        int niveis = 0;
+        while ((1 << (niveis + 1)) <= threads)
+            niveis++;
+
+        raiz = constroi(ordenados.data(), 0, ordenados.size(), nullptr, niveis);
+        if (indice != nullptr)
+            indexa(raiz);
+        if (filtro != nullptr)
+            ativa_filtro_bloom();
+        avisa(true, ordenados.data(), ordenados.size());
+        alteracoes = 0; // Recém-construída: os nós já estão na ordem da construção
+    };
+
+    /**
+     * @brief Insere um lote de códigos em uma única passada pela árvore.
+     * 
+     * @details O lote é ordenado e cada parte é mesclada apenas na subárvore a que pertence, com um único ajuste de balanceamento por subárvore afetada. Códigos repetidos no lote contam como já presentes.
+     * @param codigos Os códigos a serem inseridos, em qualquer ordem.
+     * @param resultado Recebe os códigos inseridos e os já presentes.
+     */
+    void insere_lote(std::vector<int> codigos, ResultadoLote &resultado) {
+        std::vector<int> repetidos;
+        ordena_sem_repeticoes(codigos, repetidos);
+
+        size_t antes = resultado.inseridos.size();
+        No *x = raiz;
+        raiz = nullptr;
+        raiz = insere_lote(x, codigos.data(), codigos.size(), resultado);
+        confere_filtro();
+        avisa(true, resultado.inseridos.data() + antes, resultado.inseridos.size() - antes);
+
+        if (!repetidos.empty()) {
+            std::vector<int> presentes;
+            std::merge(resultado.presentes.begin(), resultado.presentes.end(), repetidos.begin(), repetidos.end(), std::back_inserter(presentes));
+            resultado.presentes.swap(presentes);
+        }
+    };
+
+    /**
+     * @brief Remove um lote de códigos em uma única passada pela árvore.
+     * 
+     * @details Códigos repetidos no lote contam como ausentes a partir da segunda ocorrência.
+     * @param codigos Os códigos a serem removidos, em qualquer ordem.
+     * @param resultado Recebe os códigos removidos e os ausentes.
+     */
+    void remove_lote(std::vector<int> codigos, ResultadoLote &resultado) {
+        std::vector<int> repetidos;
+        ordena_sem_repeticoes(codigos, repetidos);
+
+        size_t antes = resultado.removidos.size();
+        No *x = raiz;
+        raiz = nullptr;
+        raiz = remove_lote(x, codigos.data(), codigos.size(), resultado);
+        if (resultado.removidos.size() > antes)
+            versao++;
+        confere_filtro();
+        avisa(false, resultado.removidos.data() + antes, resultado.removidos.size() - antes);
+
+        if (!repetidos.empty()) {
+            std::vector<int> ausentes;
+            std::merge(resultado.ausentes.begin(), resultado.ausentes.end(), repetidos.begin(), repetidos.end(), std::back_inserter(ausentes));
+            resultado.ausentes.swap(ausentes);
+        }
+    };
+
+    /**
+     * @brief Aplica um lote de remoções seguido de um lote de inserções.
+     * 
+     * @param insercoes Os códigos a serem inseridos.
+     * @param remocoes Os códigos a serem removidos.
+     * @return O resultado do lote.
+     */
+    ResultadoLote aplica_lote(const std::vector<int> &insercoes, const std::vector<int> &remocoes) {
+        ResultadoLote resultado;
+        if (!remocoes.empty())
+            remove_lote(remocoes, resultado);
+        insere_lote(insercoes, resultado);
+        return resultado;
+    };
+
+    /**
+     * @brief Limpa a árvore AVL.
+     */
+    void limpa() {
+        avisa_todos(false);
+        limpa(raiz);
+        raiz = nullptr;
+        alteracoes = 0;
+        versao++;
+        if (indice != nullptr)
+            indice->limpa();
+        if (filtro != nullptr)
+            filtro->refaz(0);
+    };
+
+    /**
+     * @brief Une a árvore AVL atual com outra árvore AVL.
+     *
+     * @param T Referência para a árvore AVL a ser unida.
+     * @param destino Referência para a árvore AVL onde o resultado será armazenado.
+     */
+    void uniao(ArvoreBalanceada &T, ArvoreBalanceada &destino)
+    {
+        uniao(this->raiz, destino);
+        uniao(T.raiz, destino);
+    }
+
+    /**
+     * @brief Intersecciona duas árvores AVL e armazena o resultado em uma terceira árvore.
+     * 
+     * @param T1 Referência para a primeira árvore AVL.
+     * @param T2 Referência para a segunda árvore AVL.
+     * @param T3 Referência para a árvore AVL onde o resultado será armazenado.
+     */
+    void intersecao(ArvoreBalanceada &T1, ArvoreBalanceada &T2, ArvoreBalanceada &T3) {
+        intersecao(T1.raiz, T2, T3);
+    };
+
+    /**
+     * @brief Une várias árvores de uma vez, sem resultados intermediários.
+     * 
+     * @details Os percursos em ordem das árvores são intercalados com um heap de mínimo, numa única passada; os códigos distintos saem ordenados e a árvore de destino é construída já balanceada a partir deles. O conteúdo anterior do destino é descartado (ele pode ser uma das árvores unidas).
+     * @param arvores As árvores a serem unidas.
+     * @param destino A árvore onde o resultado será armazenado.
+     */
+    static void uniao(const std::vector<ArvoreBalanceada *> &arvores, ArvoreBalanceada &destino) {
+        typedef std::pair<int, size_t> Cabeca; // Código e índice da árvore
+        std::priority_queue<Cabeca, std::vector<Cabeca>, std::greater<Cabeca> > heap;
+        std::vector<No *> atual(arvores.size(), nullptr);
+        for (size_t i = 0; i < arvores.size(); i++) {
+            if (arvores[i]->raiz != nullptr) {
+                atual[i] = arvores[i]->minimo(arvores[i]->raiz);
+                heap.push(Cabeca(atual[i]->codigo, i));
+            }
+        }
+
+        std::vector<int> ordenados;
+        while (!heap.empty()) {
+            Cabeca c = heap.top();
+            heap.pop();
+            if (ordenados.empty() || ordenados.back() != c.first)
+                ordenados.push_back(c.first);
+
+            atual[c.second] = arvores[c.second]->sucessor(atual[c.second]);
+            if (atual[c.second] != nullptr)
+                heap.push(Cabeca(atual[c.second]->codigo, c.second));
+        }
+
+        destino.limpa();
+        destino.carrega_ordenado(ordenados);
+    };
+
+    /**
+     * @brief Intersecciona várias árvores de uma vez, sem resultados intermediários.
+     * 
+     * @details Um código candidato passa de árvore em árvore: cada uma o substitui pelo seu teto, buscado a partir do último nó visitado nela, até que todas concordem. Assim, trechos que faltam em alguma árvore são saltados em vez de percorridos. Os códigos comuns saem ordenados e a árvore de destino é construída já balanceada a partir deles; seu conteúdo anterior é descartado.
+     * @param arvores As árvores a serem interseccionadas.
+     * @param destino A árvore onde o resultado será armazenado.
+     */
+    static void intersecao(const std::vector<ArvoreBalanceada *> &arvores, ArvoreBalanceada &destino) {
+        size_t n = arvores.size();
+        std::vector<No *> dedos(n);
+        bool vazia = n == 0;
+        for (size_t i = 0; i < n; i++) {
+            dedos[i] = arvores[i]->raiz;
+            vazia = vazia || dedos[i] == nullptr;
+        }
+
+        std::vector<int> ordenados;
+        int alvo = INT_MIN;
+        size_t concordam = 0;
+        for (size_t i = 0; !vazia; i = (i + 1) % n) {
+            No *x = arvores[i]->teto_a_partir(dedos[i], alvo);
+            if (x == nullptr)
+                break;
+            if (x->codigo != alvo) {
+                alvo = x->codigo;
+                concordam = 1;
+            } else if (++concordam < n) {
+                continue;
+            }
+
+            if (concordam == n) {
+                ordenados.push_back(alvo);
+                if (alvo == INT_MAX)
+                    break;
+                alvo++;
+                concordam = 0;
+            }
+        }
+
+        destino.limpa();
+        destino.carrega_ordenado(ordenados);
+    };
+
+    /**
+     * @brief Busca elementos dentro de um intervalo de chaves.
+     * 
+     * @param min O valor mínimo da chave.
+     * @param max O valor máximo da chave.
+     */
+    void busca_intervalo(int min, int max) {
+        busca_intervalo(raiz, min, max);
+    };
+
+    /**
+     * @brief Escreve a árvore AVL na saída padrão.
+     * 
+     * @param prefixo A string de prefixo para formatar a saída.
+     * @param x Ponteiro para o nó de onde a escrita começa.
+     */
+    void escreve(const char* prefixo = "", No* x = nullptr, bool isLeft = true) {
+        if (x != nullptr) {
+            std::cout << prefixo;
+            std::cout << (isLeft ? "├── " : "└── ");
+            x->escreve("\n");
+
+            // Cria novos prefixos para os filhos esquerdo e direito
+            char novoPrefixoEsq[100];
+            char novoPrefixoDir[100];
+
+            copia_string(novoPrefixoEsq, prefixo);
+            copia_string(novoPrefixoDir, prefixo);
+
+            if (isLeft) {
+                concatena_string(novoPrefixoEsq, "│   ");
+                concatena_string(novoPrefixoDir, "    ");
+            } else {
+                concatena_string(novoPrefixoEsq, "    ");
+                concatena_string(novoPrefixoDir, "    ");
+            }
+
+            escreve(novoPrefixoEsq, x->esq, true);
+            escreve(novoPrefixoDir, x->dir, false);
+        }
+    };
+    /**
+     * @brief Copia uma string para outra.
+     * @param destino Ponteiro para a string de destino.
+     * @param origem Ponteiro para a string de origem.
+     */
+    void copia_string(char *destino, const char *origem) {
+        while (*origem)
+        {
+            *destino++ = *origem++;
+        }
+        *destino = '\0';
+    }
+
+    /**
+     * @brief Concatena uma string a outra.
+     * @param destino Ponteiro para a string de destino.
+     * @param origem Ponteiro para a string de origem.
+     */
+    void concatena_string(char *destino, const char *origem) {
+        while (*destino)
+        {
+            destino++;
+        }
+        copia_string(destino, origem);
+    };
+};
+
+typedef ArvoreBalanceada<BalanceamentoAVL> AVL;
+typedef ArvoreBalanceada<BalanceamentoWAVL> WAVL;
+
+/**
+ * @class VisaoConjuntos
+ * @brief União e interseção de duas árvores, materializadas e mantidas a cada inserção e remoção nelas.
+ *
+ * @details A visão se registra como observadora de T1 e T2 e guarda, para cada código, quantas ocorrências ele tem em cada uma. Um código entra na união quando passa a ter alguma ocorrência e sai quando perde a última; entra na interseção quando passa a ocorrer nas duas árvores. Os lotes de avisos são aplicados às árvores da visão como lotes. Ler a visão não exige recálculo: as árvores resultantes estão sempre atualizadas. Avisos de árvores diferentes podem chegar de threads diferentes.
+ */
+class VisaoConjuntos : public ObservadorArvore
+{
+private:
+
+    struct Contagem
+    {
+        int ocorrencias[2]; // Em T1 e em T2
+    };
+
+    AVL *arvores[2];
+    AVL uniao;
+    AVL intersecao;
+    std::unordered_map<int, Contagem> contagens;
+    std::mutex trava;
+
+    /**
+     * @brief Aplica uma mudança de ocorrências e coleta as entradas e saídas das árvores da visão.
+     */
+    void aplica(int origem, const int *codigos, size_t n, int delta) {
+        std::vector<int> uniao_entra, uniao_sai, intersecao_entra, intersecao_sai;
+        for (size_t i = 0; i < n; i++) {
+            Contagem &c = contagens[codigos[i]];
+            bool estava_uniao = c.ocorrencias[0] + c.ocorrencias[1] > 0;
+            bool estava_intersecao = c.ocorrencias[0] > 0 && c.ocorrencias[1] > 0;
+            c.ocorrencias[origem] += delta;
+            bool esta_uniao = c.ocorrencias[0] + c.ocorrencias[1] > 0;
+            bool esta_intersecao = c.ocorrencias[0] > 0 && c.ocorrencias[1] > 0;
+
+            if (!estava_uniao && esta_uniao)
+                uniao_entra.push_back(codigos[i]);
+            else if (estava_uniao && !esta_uniao)
+                uniao_sai.push_back(codigos[i]);
+            if (!estava_intersecao && esta_intersecao)
+                intersecao_entra.push_back(codigos[i]);
+            else if (estava_intersecao && !esta_intersecao)
+                intersecao_sai.push_back(codigos[i]);
+
+            if (!esta_uniao)
+                contagens.erase(codigos[i]);
+        }
+
+        if (!uniao_entra.empty() || !uniao_sai.empty())
+            uniao.aplica_lote(uniao_entra, uniao_sai);
+        if (!intersecao_entra.empty() || !intersecao_sai.empty())
+            intersecao.aplica_lote(intersecao_entra, intersecao_sai);
+    }
+
+public:
+
+    /**
+     * @brief Construtor da visão: calcula a união e a interseção atuais e passa a acompanhar as duas árvores.
+     * 
+     * @details A visão deve ser destruída antes de T1 e T2.
+     * @param T1 A primeira árvore.
+     * @param T2 A segunda árvore.
+     */
+    VisaoConjuntos(AVL &T1, AVL &T2) {
+        arvores[0] = &T1;
+        arvores[1] = &T2;
+        for (int lado = 0; lado < 2; lado++) {
+            std::vector<int> codigos;
+            arvores[lado]->em_ordem(codigos);
+            aplica(lado, codigos.data(), codigos.size(), 1);
+            arvores[lado]->registra(this, lado);
+        }
+    }
+
+    /**
+     * @brief Destrutor: deixa de acompanhar as duas árvores.
+     */
+    ~VisaoConjuntos() {
+        arvores[0]->desregistra(this);
+        arvores[1]->desregistra(this);
+    }
+
+    VisaoConjuntos(const VisaoConjuntos &) = delete;
+    VisaoConjuntos &operator=(const VisaoConjuntos &) = delete;
+
+    void inseridos(int origem, const int *codigos, size_t n) {
+        std::lock_guard<std::mutex> guarda(trava);
+        aplica(origem, codigos, n, 1);
+    }
+
+    void removidos(int origem, const int *codigos, size_t n) {
+        std::lock_guard<std::mutex> guarda(trava);
+        aplica(origem, codigos, n, -1);
+    }
+
+    /**
+     * @brief Retorna a união de T1 e T2 (cada código uma vez).
+     */
+    AVL &get_uniao() {
+        return uniao;
+    }
+
+    /**
+     * @brief Retorna a interseção de T1 e T2 (cada código uma vez).
+     */
+    AVL &get_intersecao() {
+        return intersecao;
+    }
+};
+
+/**
+ * @class DedoBalanceado
+ * @brief Cursor que lembra o último nó visitado de uma árvore AVL.
+ *
+ * @details As buscas partem do nó lembrado em vez da raiz, subindo pelos ancestrais só o necessário. Em sequências de consultas quase ordenadas (como uma lista de separação de pedidos), cada busca custa O(1) amortizado. Se a árvore liberar nós, o cursor recomeça da raiz.
+ */
+template <typename Politica>
+class DedoBalanceado
+{
+private:
+
+    ArvoreBalanceada<Politica> *arvore;
+    No *no;
+    unsigned long versao;
+
+    /**
+     * @brief Garante que o nó lembrado ainda é válido, recomeçando da raiz se preciso.
+     * @return false se a árvore estiver vazia.
+     */
+    bool sincroniza() {
+        if (no == nullptr || versao != arvore->get_versao()) {
+            no = arvore->get_raiz();
+            versao = arvore->get_versao();
+        }
+        return no != nullptr;
+    }
+
+public:
+
+    /**
+     * @brief Construtor do cursor, posicionado na raiz da árvore.
+     * @param T A árvore percorrida.
+     */
+    DedoBalanceado(ArvoreBalanceada<Politica> &T) : arvore(&T), no(nullptr), versao(0) {}
+
+    /**
+     * @brief Busca uma chave a partir do último nó visitado.
+     * @param k A chave a ser buscada.
+     * @return Ponteiro para o nó com a chave, ou nullptr se não encontrado.
+     */
+    No *busca(int k) {
+        return sincroniza() ? arvore->busca_a_partir(no, k) : nullptr;
+    }
+
+    /**
+     * @brief Encontra a maior chave menor ou igual a k a partir do último nó visitado.
+     * @param k A chave de referência.
+     */
+    No *piso(int k) {
+        return sincroniza() ? arvore->piso_a_partir(no, k) : nullptr;
+    }
+
+    /**
+     * @brief Encontra a menor chave maior ou igual a k a partir do último nó visitado.
+     * @param k A chave de referência.
+     */
+    No *teto(int k) {
+        return sincroniza() ? arvore->teto_a_partir(no, k) : nullptr;
+    }
+
+    /**
+     * @brief Retorna o último nó visitado.
+     */
+    No *atual() const {
+        return no;
+    }
+};
+
+typedef DedoBalanceado<BalanceamentoAVL> Dedo;
+
+/**
+ * @brief Número de códigos por bloco do inventário compactado.
+ */
+#define TAM_BLOCO_COMPACTO 128
+
+/**
+ * @class InventarioCompactado
+ * @brief Inventário somente leitura, com os códigos ordenados comprimidos em blocos.
+ *
+ * @details Os códigos distintos são divididos em blocos de TAM_BLOCO_COMPACTO. Cada bloco guarda, no índice de saltos, o primeiro e o último código; os demais são gravados como diferenças para o anterior (menos 1), empacotadas com o menor número de bits que comporta a maior diferença do bloco. Códigos densos custam poucos bits cada (zero bits em sequências contíguas). Buscas, varreduras de intervalo e interseções consultam o índice de saltos e decodificam só os blocos tocados; a decodificação é um laço sem desvios sobre o bloco inteiro.
+ */
+class InventarioCompactado
+{
+private:
+
+    struct Bloco
+    {
+        int ultimo;       // Último código do bloco
+        uint32_t inicio;  // Primeira palavra do bloco em `dados`
+        uint8_t bits;     // Bits por diferença
+        uint8_t quantidade;
+    };
+
+    std::vector<int> primeiros; // Primeiro código de cada bloco, separado para a busca binária
+    std::vector<Bloco> blocos;
+    std::vector<uint32_t> dados;
+    long long total;
+
+    /**
+     * @brief Retorna o bloco que pode conter um código, ou -1 se ele for menor que todos.
+     * @param codigo O código.
+     */
+    long bloco_de(int codigo) const {
+        return (long) (std::upper_bound(primeiros.begin(), primeiros.end(), codigo) - primeiros.begin()) - 1;
+    }
+
+    /**
+     * @brief Decodifica um bloco.
+     * @param b O índice do bloco.
+     * @param saida Recebe os códigos (espaço para TAM_BLOCO_COMPACTO).
+     * @return O número de códigos do bloco.
+     */
+    int decodifica(size_t b, int *saida) const {
+        const Bloco &bloco = blocos[b];
+        const uint32_t *p = dados.data() + bloco.inicio;
+        uint32_t bits = bloco.bits;
+        uint64_t mascara = (1ULL << bits) - 1;
+        int n = bloco.quantidade;
+
+        // Desempacota as diferenças (duas palavras cobrem qualquer posição; há folga no fim de `dados`)
+        uint32_t atual = (uint32_t) primeiros[b];
+        saida[0] = primeiros[b];
+        for (int j = 1; j < n; j++) {
+            uint32_t pos = (uint32_t) (j - 1) * bits;
+            uint64_t par = p[pos >> 5] | ((uint64_t) p[(pos >> 5) + 1] << 32);
+            atual += (uint32_t) ((par >> (pos & 31)) & mascara) + 1;
+            saida[j] = (int) atual;
+        }
+        return n;
+    }
+
+public:
+
+    /**
+     * @brief Construtor a partir de códigos ordenados e sem repetições.
+     * @param ordenados Os códigos.
+     */
+    InventarioCompactado(const std::vector<int> &ordenados) : total((long long) ordenados.size()) {
+        for (size_t i = 0; i < ordenados.size(); i += TAM_BLOCO_COMPACTO) {
+            size_t n = std::min((size_t) TAM_BLOCO_COMPACTO, ordenados.size() - i);
+            const int *c = ordenados.data() + i;
+
+            // Bits necessários para a maior diferença do bloco
+            uint32_t maior = 0;
+            for (size_t j = 1; j < n; j++)
+                maior = std::max(maior, (uint32_t) c[j] - (uint32_t) c[j - 1] - 1);
+            uint32_t bits = 0;
+            while (bits < 32 && (maior >> bits) != 0)
+                bits++;
+
+            Bloco bloco;
+            bloco.ultimo = c[n - 1];
+            bloco.inicio = (uint32_t) dados.size();
+            bloco.bits = (uint8_t) bits;
+            bloco.quantidade = (uint8_t) n;
+            primeiros.push_back(c[0]);
+            blocos.push_back(bloco);
+
+            dados.resize(dados.size() + ((n - 1) * bits + 31) / 32, 0);
+            uint32_t *p = dados.data() + bloco.inicio;
+            for (size_t j = 1; j < n && bits > 0; j++) {
+                uint32_t v = (uint32_t) c[j] - (uint32_t) c[j - 1] - 1;
+                uint32_t pos = (uint32_t) (j - 1) * bits;
+                p[pos >> 5] |= v << (pos & 31);
+                if ((pos & 31) + bits > 32)
+                    p[(pos >> 5) + 1] |= v >> (32 - (pos & 31));
+            }
+        }
+
+        // Folga para a leitura de duas palavras na decodificação
+        dados.push_back(0);
+        dados.push_back(0);
+        dados.shrink_to_fit();
+        primeiros.shrink_to_fit();
+        blocos.shrink_to_fit();
+    }
+
+    /**
+     * @brief Construtor a partir dos códigos distintos de uma árvore.
+     * @param T A árvore.
+     */
+    InventarioCompactado(AVL &T) : total(0) {
+        std::vector<int> codigos;
+        T.em_ordem(codigos);
+        codigos.erase(std::unique(codigos.begin(), codigos.end()), codigos.end());
+        *this = InventarioCompactado(codigos);
+    }
+
+    /**
+     * @brief Retorna o número de códigos.
+     */
+    long long tamanho() const {
+        return total;
+    }
+
+    /**
+     * @brief Retorna a memória ocupada, em bytes.
+     */
+    size_t memoria() const {
+        return sizeof(*this) + primeiros.capacity() * sizeof(int) + blocos.capacity() * sizeof(Bloco) + dados.capacity() * sizeof(uint32_t);
+    }
+
+    /**
+     * @brief Verifica se um código está no inventário, decodificando no máximo um bloco.
+     * @param codigo O código.
+     */
+    bool busca(int codigo) const {
+        long b = bloco_de(codigo);
+        if (b < 0 || codigo > blocos[b].ultimo)
+            return false;
+
+        int codigos[TAM_BLOCO_COMPACTO];
+        int n = decodifica(b, codigos);
+        return std::binary_search(codigos, codigos + n, codigo);
+    }
+
+    /**
+     * @brief Acrescenta a um vetor, em ordem, os códigos de um intervalo.
+     * @param min O menor código do intervalo.
+     * @param max O maior código do intervalo.
+     * @param saida O vetor de saída.
+     */
+    void busca_intervalo(int min, int max, std::vector<int> &saida) const {
+        long b = std::max(bloco_de(min), 0L);
+        int codigos[TAM_BLOCO_COMPACTO];
+        for (; b < (long) blocos.size() && primeiros[b] <= max; b++) {
+            if (blocos[b].ultimo < min)
+                continue;
+            int n = decodifica(b, codigos);
+            for (int j = 0; j < n; j++)
+                if (codigos[j] >= min && codigos[j] <= max)
+                    saida.push_back(codigos[j]);
+        }
+    }
+
+    /**
+     * @brief Conta os códigos de um intervalo; blocos inteiramente dentro dele não são decodificados.
+     * @param min O menor código do intervalo.
+     * @param max O maior código do intervalo.
+     */
+    long long conta_intervalo(int min, int max) const {
+        long long n = 0;
+        long b = std::max(bloco_de(min), 0L);
+        int codigos[TAM_BLOCO_COMPACTO];
+        for (; b < (long) blocos.size() && primeiros[b] <= max; b++) {
+            if (blocos[b].ultimo < min)
+                continue;
+            if (primeiros[b] >= min && blocos[b].ultimo <= max) {
+                n += blocos[b].quantidade;
+                continue;
+            }
+            int q = decodifica(b, codigos);
+            for (int j = 0; j < q; j++)
+                n += codigos[j] >= min && codigos[j] <= max;
+        }
+        return n;
+    }
+
+    /**
+     * @brief Intersecciona dois inventários compactados, decodificando só os pares de blocos cujas faixas se sobrepõem.
+     * @param A O primeiro inventário.
+     * @param B O segundo inventário.
+     * @return Os códigos comuns, em ordem.
+     */
+    static std::vector<int> intersecao(const InventarioCompactado &A, const InventarioCompactado &B) {
+        std::vector<int> saida;
+        int ca[TAM_BLOCO_COMPACTO], cb[TAM_BLOCO_COMPACTO];
+        long da = -1, db = -1; // Blocos já decodificados
+        int na = 0, nb = 0;
+
+        size_t i = 0, j = 0;
+        while (i < A.blocos.size() && j < B.blocos.size()) {
+            // Faixas disjuntas: avança o bloco que termina antes
+            if (A.blocos[i].ultimo < B.primeiros[j]) {
+                i++;
+                continue;
+            }
+            if (B.blocos[j].ultimo < A.primeiros[i]) {
+                j++;
+                continue;
+            }
+
+            if (da != (long) i) {
+                na = A.decodifica(i, ca);
+                da = i;
+            }
+            if (db != (long) j) {
+                nb = B.decodifica(j, cb);
+                db = j;
+            }
+            std::set_intersection(ca, ca + na, cb, cb + nb, std::back_inserter(saida));
+
+            // Cada código de um bloco só pode casar com blocos que cruzam sua faixa
+            if (A.blocos[i].ultimo < B.blocos[j].ultimo)
+                i++;
+            else if (B.blocos[j].ultimo < A.blocos[i].ultimo)
+                j++;
+            else {
+                i++;
+                j++;
+            }
+        }
+        return saida;
+    }
+};
+
+/**
+ * @class ArvoreRadix
+ * @brief Árvore radix adaptativa (ART) de códigos, indexada pelos 4 bytes de cada código.
+ *
+ * @details Cada nível consome um byte do código (com o bit de sinal invertido, para que a ordem dos bytes siga a ordem dos inteiros), então uma busca desce no máximo 4 níveis. Os nós internos crescem e encolhem entre 4, 16, 48 e 256 filhos conforme a ocupação; o nó de 16 é buscado com uma comparação SSE2 dos 16 bytes de uma vez, quando disponível. Bytes comuns a todos os códigos de uma subárvore ficam no prefixo do nó (compressão de caminho), e um código sozinho numa subárvore fica guardado no próprio ponteiro do filho, sem alocação (expansão preguiçosa). Ao contrário da AVL, cada código aparece no máximo uma vez.
+ */
+class ArvoreRadix
+{
+private:
+
+    enum TipoNoRadix { NO4, NO16, NO48, NO256 };
+
+    // Um filho é um ponteiro para nó (bit 0 em zero) ou uma folha com a chave (bit 0 em um); 0 é vazio
+    typedef uint64_t Filho;
+
+    struct NoRadix
+    {
+        uint8_t tipo;
+        uint16_t num_filhos;
+        uint8_t prefixo_tam;
+        uint8_t prefixo[3];
+    };
+
+    struct NoRadix4 : NoRadix
+    {
+        uint8_t chaves[4];
+        Filho filhos[4];
+    };
+
+    struct NoRadix16 : NoRadix
+    {
+        uint8_t chaves[16];
+        Filho filhos[16];
+    };
+
+    struct NoRadix48 : NoRadix
+    {
+        uint8_t indice[256]; // Posição + 1 do filho de cada byte, ou 0
+        Filho filhos[48];
+    };
+
+    struct NoRadix256 : NoRadix
+    {
+        Filho filhos[256];
+    };
+
+    Filho raiz;
+    long long quantidade;
+    size_t bytes; // Memória ocupada pelos nós
+
+    static inline uint32_t chave(int codigo) { return (uint32_t) codigo ^ 0x80000000u; }
+    static inline int codigo(uint32_t chave) { return (int) (chave ^ 0x80000000u); }
+    static inline uint8_t byte(uint32_t chave, int profundidade) { return (uint8_t) (chave >> (24 - 8 * profundidade)); }
+    static inline bool eh_folha(Filho f) { return (f & 1) != 0; }
+    static inline Filho folha(uint32_t chave) { return ((Filho) chave << 1) | 1; }
+    static inline uint32_t chave_da_folha(Filho f) { return (uint32_t) (f >> 1); }
+    static inline NoRadix *no(Filho f) { return (NoRadix *) (uintptr_t) f; }
+    static inline Filho filho(NoRadix *n) { return (Filho) (uintptr_t) n; }
+
+    /**
+     * @brief Retorna o tamanho, em bytes, de um nó do tipo dado.
+     */
+    static size_t tamanho_no(int tipo) {
+        switch (tipo) {
+            case NO4: return sizeof(NoRadix4);
+            case NO16: return sizeof(NoRadix16);
+            case NO48: return sizeof(NoRadix48);
+            default: return sizeof(NoRadix256);
+        }
+    }
+
+    /**
+     * @brief Cria um nó vazio do tipo dado, copiando o prefixo de outro nó, se houver.
+     */
+    NoRadix *cria(int tipo, const NoRadix *modelo = nullptr) {
+        NoRadix *n;
+        switch (tipo) {
+            case NO4: n = new NoRadix4(); break;
+            case NO16: n = new NoRadix16(); break;
+            case NO48: n = new NoRadix48(); break;
+            default: n = new NoRadix256(); break;
+        }
+        n->tipo = (uint8_t) tipo;
+        n->num_filhos = 0;
+        n->prefixo_tam = modelo ? modelo->prefixo_tam : 0;
+        if (modelo)
+            memcpy(n->prefixo, modelo->prefixo, 3);
+        bytes += tamanho_no(tipo);
+        return n;
+    }
+
+    /**
+     * @brief Libera um nó (sem os filhos).
+     */
+    void destroi(NoRadix *n) {
+        bytes -= tamanho_no(n->tipo);
+        switch (n->tipo) {
+            case NO4: delete static_cast<NoRadix4 *>(n); break;
+            case NO16: delete static_cast<NoRadix16 *>(n); break;
+            case NO48: delete static_cast<NoRadix48 *>(n); break;
+            default: delete static_cast<NoRadix256 *>(n); break;
+        }
+    }
+
+    /**
+     * @brief Libera uma subárvore.
+     */
+    void limpa(Filho f) {
+        if (f == 0 || eh_folha(f))
+            return;
+        NoRadix *n = no(f);
+        percorre_filhos(n, 0, 255, false, [this](uint8_t, Filho c) {
+            limpa(c);
+            return true;
+        });
+        destroi(n);
+    }
+
+    /**
+     * @brief Visita, em ordem de byte, os filhos de um nó com byte em [de, ate].
+     *
+     * @details Só as posições ocupadas são visitadas: os nós de 4 e 16 pelas chaves (que ficam ordenadas), o de 48 pelo índice e o de 256 pelas posições não vazias.
+     * @param decrescente Visita do maior byte para o menor.
+     * @param visita Chamada com o byte e o filho; a visita para quando ela retorna false.
+     */
+    template <typename Visita>
+    static void percorre_filhos(NoRadix *n, int de, int ate, bool decrescente, Visita visita) {
+        switch (n->tipo) {
+            case NO4:
+            case NO16: {
+                const uint8_t *chaves;
+                const Filho *filhos;
+                if (n->tipo == NO4) {
+                    chaves = static_cast<NoRadix4 *>(n)->chaves;
+                    filhos = static_cast<NoRadix4 *>(n)->filhos;
+                }
+                else {
+                    chaves = static_cast<NoRadix16 *>(n)->chaves;
+                    filhos = static_cast<NoRadix16 *>(n)->filhos;
+                }
+                int num = n->num_filhos;
+                for (int j = 0; j < num; j++) {
+                    int i = decrescente ? num - 1 - j : j;
+                    if (chaves[i] < de || chaves[i] > ate) {
+                        if (decrescente ? chaves[i] < de : chaves[i] > ate)
+                            return;
+                        continue;
+                    }
+                    if (!visita(chaves[i], filhos[i]))
+                        return;
+                }
+                return;
+            }
+            case NO48: {
+                NoRadix48 *n48 = static_cast<NoRadix48 *>(n);
+                for (int j = de; j <= ate; j++) {
+                    int b = decrescente ? de + ate - j : j;
+                    if (n48->indice[b] && !visita((uint8_t) b, n48->filhos[n48->indice[b] - 1]))
+                        return;
+                }
+                return;
+            }
+            default: {
+                NoRadix256 *n256 = static_cast<NoRadix256 *>(n);
+                for (int j = de; j <= ate; j++) {
+                    int b = decrescente ? de + ate - j : j;
+                    if (n256->filhos[b] && !visita((uint8_t) b, n256->filhos[b]))
+                        return;
+                }
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Procura o filho de um byte.
+     * @return Ponteiro para a posição do filho, ou nullptr se não houver.
+     */
+    static Filho *procura(NoRadix *n, uint8_t b) {
+        switch (n->tipo) {
+            case NO4: {
+                NoRadix4 *n4 = static_cast<NoRadix4 *>(n);
+                for (int i = 0; i < n4->num_filhos; i++)
+                    if (n4->chaves[i] == b)
+                        return &n4->filhos[i];
+                return nullptr;
+            }
+            case NO16: {
+                NoRadix16 *n16 = static_cast<NoRadix16 *>(n);
+#ifdef __SSE2__
+                // Compara o byte com as 16 chaves de uma vez
+                __m128i iguais = _mm_cmpeq_epi8(_mm_set1_epi8((char) b), _mm_loadu_si128((const __m128i *) n16->chaves));
+                int mascara = _mm_movemask_epi8(iguais) & ((1 << n16->num_filhos) - 1);
+                return mascara ? &n16->filhos[__builtin_ctz(mascara)] : nullptr;
+#else
+                for (int i = 0; i < n16->num_filhos; i++)
+                    if (n16->chaves[i] == b)
+                        return &n16->filhos[i];
+                return nullptr;
+#endif
+            }
+            case NO48: {
+                NoRadix48 *n48 = static_cast<NoRadix48 *>(n);
+                return n48->indice[b] ? &n48->filhos[n48->indice[b] - 1] : nullptr;
+            }
+            default: {
+                NoRadix256 *n256 = static_cast<NoRadix256 *>(n);
+                return n256->filhos[b] ? &n256->filhos[b] : nullptr;
+            }
+        }
+    }
+
+    /**
+     * @brief Acrescenta um filho a um nó, trocando-o por um maior se estiver cheio.
+     * @param f Posição que aponta para o nó (atualizada se ele crescer).
+     * @param b O byte do filho.
+     * @param c O filho.
+     */
+    void adiciona(Filho &f, uint8_t b, Filho c) {
+        NoRadix *n = no(f);
+        switch (n->tipo) {
+            case NO4: {
+                NoRadix4 *n4 = static_cast<NoRadix4 *>(n);
+                if (n4->num_filhos == 4) {
+                    NoRadix16 *n16 = static_cast<NoRadix16 *>(cria(NO16, n4));
+                    memcpy(n16->chaves, n4->chaves, 4);
+                    memcpy(n16->filhos, n4->filhos, 4 * sizeof(Filho));
+                    n16->num_filhos = 4;
+                    destroi(n4);
+                    f = filho(n16);
+                    adiciona(f, b, c);
+                    return;
+                }
+                int i = 0;
+                while (i < n4->num_filhos && n4->chaves[i] < b)
+                    i++;
+                memmove(n4->chaves + i + 1, n4->chaves + i, n4->num_filhos - i);
+                memmove(n4->filhos + i + 1, n4->filhos + i, (n4->num_filhos - i) * sizeof(Filho));
+                n4->chaves[i] = b;
+                n4->filhos[i] = c;
+                n4->num_filhos++;
+                return;
+            }
+            case NO16: {
+                NoRadix16 *n16 = static_cast<NoRadix16 *>(n);
+                if (n16->num_filhos == 16) {
+                    NoRadix48 *n48 = static_cast<NoRadix48 *>(cria(NO48, n16));
+                    for (int i = 0; i < 16; i++) {
+                        n48->indice[n16->chaves[i]] = (uint8_t) (i + 1);
+                        n48->filhos[i] = n16->filhos[i];
+                    }
+                    n48->num_filhos = 16;
+                    destroi(n16);
+                    f = filho(n48);
+                    adiciona(f, b, c);
+                    return;
+                }
+                int i = 0;
+                while (i < n16->num_filhos && n16->chaves[i] < b)
+                    i++;
+                memmove(n16->chaves + i + 1, n16->chaves + i, n16->num_filhos - i);
+                memmove(n16->filhos + i + 1, n16->filhos + i, (n16->num_filhos - i) * sizeof(Filho));
+                n16->chaves[i] = b;
+                n16->filhos[i] = c;
+                n16->num_filhos++;
+                return;
+            }
+            case NO48: {
+                NoRadix48 *n48 = static_cast<NoRadix48 *>(n);
+                if (n48->num_filhos == 48) {
+                    NoRadix256 *n256 = static_cast<NoRadix256 *>(cria(NO256, n48));
+                    for (int k = 0; k < 256; k++)
+                        if (n48->indice[k])
+                            n256->filhos[k] = n48->filhos[n48->indice[k] - 1];
+                    n256->num_filhos = 48;
+                    destroi(n48);
+                    f = filho(n256);
+                    adiciona(f, b, c);
+                    return;
+                }
+                // Os filhos ficam contíguos: o novo vai para o fim
+                n48->filhos[n48->num_filhos] = c;
+                n48->indice[b] = (uint8_t) (n48->num_filhos + 1);
+                n48->num_filhos++;
+                return;
+            }
+            default: {
+                NoRadix256 *n256 = static_cast<NoRadix256 *>(n);
+                n256->filhos[b] = c;
+                n256->num_filhos++;
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Retira o filho de um byte, trocando o nó por um menor se ele ficar pouco ocupado.
+     * @param f Posição que aponta para o nó (atualizada se ele encolher).
+     * @param b O byte do filho.
+     */
+    void retira(Filho &f, uint8_t b) {
+        NoRadix *n = no(f);
+        switch (n->tipo) {
+            case NO4: {
+                NoRadix4 *n4 = static_cast<NoRadix4 *>(n);
+                int i = 0;
+                while (n4->chaves[i] != b)
+                    i++;
+                memmove(n4->chaves + i, n4->chaves + i + 1, n4->num_filhos - i - 1);
+                memmove(n4->filhos + i, n4->filhos + i + 1, (n4->num_filhos - i - 1) * sizeof(Filho));
+                n4->num_filhos--;
+
+                // Um só filho: o nó some e seu byte e prefixo passam para o filho
+                if (n4->num_filhos == 1) {
+                    Filho c = n4->filhos[0];
+                    if (!eh_folha(c)) {
+                        NoRadix *cn = no(c);
+                        uint8_t prefixo[3];
+                        int tam = 0;
+                        for (int j = 0; j < n4->prefixo_tam; j++)
+                            prefixo[tam++] = n4->prefixo[j];
+                        prefixo[tam++] = n4->chaves[0];
+                        for (int j = 0; j < cn->prefixo_tam; j++)
+                            prefixo[tam++] = cn->prefixo[j];
+                        memcpy(cn->prefixo, prefixo, tam);
+                        cn->prefixo_tam = (uint8_t) tam;
+                    }
+                    destroi(n4);
+                    f = c;
+                }
+                return;
+            }
+            case NO16: {
+                NoRadix16 *n16 = static_cast<NoRadix16 *>(n);
+                int i = 0;
+                while (n16->chaves[i] != b)
+                    i++;
+                memmove(n16->chaves + i, n16->chaves + i + 1, n16->num_filhos - i - 1);
+                memmove(n16->filhos + i, n16->filhos + i + 1, (n16->num_filhos - i - 1) * sizeof(Filho));
+                n16->num_filhos--;
+
+                if (n16->num_filhos == 3) {
+                    NoRadix4 *n4 = static_cast<NoRadix4 *>(cria(NO4, n16));
+                    memcpy(n4->chaves, n16->chaves, 3);
+                    memcpy(n4->filhos, n16->filhos, 3 * sizeof(Filho));
+                    n4->num_filhos = 3;
+                    destroi(n16);
+                    f = filho(n4);
+                }
+                return;
+            }
+            case NO48: {
+                NoRadix48 *n48 = static_cast<NoRadix48 *>(n);
+                // O último filho ocupa a posição liberada, mantendo-os contíguos
+                int pos = n48->indice[b] - 1;
+                int ultimo = n48->num_filhos - 1;
+                n48->indice[b] = 0;
+                if (pos != ultimo) {
+                    n48->filhos[pos] = n48->filhos[ultimo];
+                    for (int k = 0; k < 256; k++) {
+                        if (n48->indice[k] == ultimo + 1) {
+                            n48->indice[k] = (uint8_t) (pos + 1);
+                            break;
+                        }
+                    }
+                }
+                n48->num_filhos--;
+
+                if (n48->num_filhos == 12) {
+                    NoRadix16 *n16 = static_cast<NoRadix16 *>(cria(NO16, n48));
+                    for (int k = 0; k < 256; k++) {
+                        if (n48->indice[k]) {
+                            n16->chaves[n16->num_filhos] = (uint8_t) k;
+                            n16->filhos[n16->num_filhos++] = n48->filhos[n48->indice[k] - 1];
+                        }
+                    }
+                    destroi(n48);
+                    f = filho(n16);
+                }
+                return;
+            }
+            default: {
+                NoRadix256 *n256 = static_cast<NoRadix256 *>(n);
+                n256->filhos[b] = 0;
+                n256->num_filhos--;
+
+                if (n256->num_filhos == 37) {
+                    NoRadix48 *n48 = static_cast<NoRadix48 *>(cria(NO48, n256));
+                    for (int k = 0; k < 256; k++) {
+                        if (n256->filhos[k]) {
+                            n48->filhos[n48->num_filhos] = n256->filhos[k];
+                            n48->indice[k] = (uint8_t) (++n48->num_filhos);
+                        }
+                    }
+                    destroi(n256);
+                    f = filho(n48);
+                }
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Insere uma chave numa subárvore.
+     * @param f Posição que aponta para a subárvore.
+     * @param k A chave.
+     * @param profundidade O byte da chave correspondente a esta posição.
+     * @return false se a chave já estava presente.
+     */
+    bool insere(Filho &f, uint32_t k, int profundidade) {
+        if (f == 0) {
+            f = folha(k);
+            return true;
+        }
+
+        if (eh_folha(f)) {
+            uint32_t outra = chave_da_folha(f);
+            if (outra == k)
+                return false;
+
+            // Um nó de 4 separa as duas chaves no primeiro byte em que diferem
+            int p = profundidade;
+            while (byte(outra, p) == byte(k, p))
+                p++;
+            NoRadix *n = cria(NO4);
+            n->prefixo_tam = (uint8_t) (p - profundidade);
+            for (int i = profundidade; i < p; i++)
+                n->prefixo[i - profundidade] = byte(k, i);
+            Filho novo = filho(n);
+            adiciona(novo, byte(outra, p), f);
+            adiciona(novo, byte(k, p), folha(k));
+            f = novo;
+            return true;
+        }
+
+        NoRadix *n = no(f);
+        for (int i = 0; i < n->prefixo_tam; i++) {
+            if (n->prefixo[i] != byte(k, profundidade + i)) {
+                // A chave diverge no meio do prefixo: um nó de 4 passa a separar os dois lados
+                NoRadix *pai = cria(NO4);
+                pai->prefixo_tam = (uint8_t) i;
+                memcpy(pai->prefixo, n->prefixo, i);
+                uint8_t byte_n = n->prefixo[i];
+                n->prefixo_tam = (uint8_t) (n->prefixo_tam - i - 1);
+                memmove(n->prefixo, n->prefixo + i + 1, n->prefixo_tam);
+
+                Filho novo = filho(pai);
+                adiciona(novo, byte_n, f);
+                adiciona(novo, byte(k, profundidade + i), folha(k));
+                f = novo;
+                return true;
+            }
+        }
+
+        profundidade += n->prefixo_tam;
+        uint8_t b = byte(k, profundidade);
+        Filho *c = procura(n, b);
+        if (c != nullptr)
+            return insere(*c, k, profundidade + 1);
+        adiciona(f, b, folha(k));
+        return true;
+    }
+
+    /**
+     * @brief Remove uma chave de uma subárvore.
+     * @param f Posição que aponta para a subárvore.
+     * @param k A chave.
+     * @param profundidade O byte da chave correspondente a esta posição.
+     * @return false se a chave não estava presente.
+     */
+    bool remove(Filho &f, uint32_t k, int profundidade) {
+        if (f == 0)
+            return false;
+        if (eh_folha(f)) {
+            if (chave_da_folha(f) != k)
+                return false;
+            f = 0;
+            return true;
+        }
+
+        NoRadix *n = no(f);
+        for (int i = 0; i < n->prefixo_tam; i++)
+            if (n->prefixo[i] != byte(k, profundidade + i))
+                return false;
+        profundidade += n->prefixo_tam;
+
+        uint8_t b = byte(k, profundidade);
+        Filho *c = procura(n, b);
+        if (c == nullptr)
+            return false;
+        if (!eh_folha(*c))
+            return remove(*c, k, profundidade + 1);
+        if (chave_da_folha(*c) != k)
+            return false;
+        retira(f, b);
+        return true;
+    }
+
+    /**
+     * @brief Acrescenta a um vetor, em ordem, as chaves de uma subárvore que estão em [min, max].
+     * @param f A subárvore.
+     * @param acumulado Os bytes já definidos pelo caminho até aqui.
+     * @param profundidade O byte da chave correspondente a esta posição.
+     */
+    void intervalo(Filho f, uint32_t acumulado, int profundidade, uint32_t min, uint32_t max, std::vector<int> &saida) const {
+        if (eh_folha(f)) {
+            uint32_t k = chave_da_folha(f);
+            if (k >= min && k <= max)
+                saida.push_back(codigo(k));
+            return;
+        }
+
+        NoRadix *n = no(f);
+        for (int i = 0; i < n->prefixo_tam; i++)
+            acumulado |= (uint32_t) n->prefixo[i] << (24 - 8 * (profundidade + i));
+        profundidade += n->prefixo_tam;
+
+        // O filho de byte b guarda chaves a partir de acumulado + (b << deslocamento)
+        int deslocamento = 24 - 8 * profundidade;
+        if (acumulado > max)
+            return;
+        uint32_t de = min > acumulado ? (min - acumulado) >> deslocamento : 0;
+        uint32_t ate = (max - acumulado) >> deslocamento;
+        if (de > 255)
+            return;
+        percorre_filhos(n, (int) de, ate > 255 ? 255 : (int) ate, false, [&](uint8_t b, Filho c) {
+            intervalo(c, acumulado | ((uint32_t) b << deslocamento), profundidade + 1, min, max, saida);
+            return true;
+        });
+    }
+
+    /**
+     * @brief Retorna o filho de menor (ou maior) byte de um nó.
+     */
+    static Filho extremo(NoRadix *n, bool maior) {
+        Filho c = 0;
+        percorre_filhos(n, 0, 255, maior, [&c](uint8_t, Filho f) {
+            c = f;
+            return false;
+        });
+        return c;
+    }
+
+    /**
+     * @brief Encontra a menor ou a maior chave.
+     * @param codigo Recebe o código.
+     * @return false se a árvore estiver vazia.
+     */
+    bool extremo(int &codigo_extremo, bool maior) const {
+        Filho f = raiz;
+        if (f == 0)
+            return false;
+        while (!eh_folha(f))
+            f = extremo(no(f), maior);
+        codigo_extremo = codigo(chave_da_folha(f));
+        return true;
+    }
+
+public:
+
+    /**
+     * @brief Construtor da árvore radix vazia.
+     */
+    ArvoreRadix() : raiz(0), quantidade(0), bytes(0) {}
+
+    /**
+     * @brief Destrutor da árvore radix.
+     */
+    ~ArvoreRadix() {
+        limpa();
+    }
+
+    ArvoreRadix(const ArvoreRadix &) = delete;
+    ArvoreRadix &operator=(const ArvoreRadix &) = delete;
+
+    /**
+     * @brief Verifica se um código está na árvore, descendo no máximo 4 níveis.
+     * @param codigo_busca O código.
+     */
+    bool busca(int codigo_busca) const {
+        uint32_t k = chave(codigo_busca);
+        Filho f = raiz;
+        int profundidade = 0;
+        while (f != 0) {
+            if (eh_folha(f))
+                return chave_da_folha(f) == k;
+
+            NoRadix *n = no(f);
+            for (int i = 0; i < n->prefixo_tam; i++)
+                if (n->prefixo[i] != byte(k, profundidade + i))
+                    return false;
+            profundidade += n->prefixo_tam;
+
+            Filho *c = procura(n, byte(k, profundidade));
+            if (c == nullptr)
+                return false;
+            f = *c;
+            profundidade++;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Insere um código.
+     * @param codigo_novo O código.
+     * @return false se o código já estava presente.
+     */
+    bool insere(int codigo_novo) {
+        bool inseriu = insere(raiz, chave(codigo_novo), 0);
+        quantidade += inseriu;
+        return inseriu;
+    }
+
+    /**
+     * @brief Remove um código.
+     * @param codigo_removido O código.
+     * @return false se o código não estava presente.
+     */
+    bool remove(int codigo_removido) {
+        bool removeu = remove(raiz, chave(codigo_removido), 0);
+        quantidade -= removeu;
+        return removeu;
+    }
+
+    /**
+     * @brief Acrescenta a um vetor, em ordem, os códigos de um intervalo.
+     * @param min O menor código do intervalo.
+     * @param max O maior código do intervalo.
+     * @param saida O vetor de saída.
+     */
+    void busca_intervalo(int min, int max, std::vector<int> &saida) const {
+        if (raiz != 0 && min <= max)
+            intervalo(raiz, 0, 0, chave(min), chave(max), saida);
+    }
+
+    /**
+     * @brief Copia todos os códigos, em ordem, para um vetor.
+     * @param saida O vetor de saída.
+     */
+    void em_ordem(std::vector<int> &saida) const {
+        busca_intervalo(INT_MIN, INT_MAX, saida);
+    }
+
+    /**
+     * @brief Encontra o menor código.
+     * @param codigo_min Recebe o código.
+     * @return false se a árvore estiver vazia.
+     */
+    bool minimo(int &codigo_min) const {
+        return extremo(codigo_min, false);
+    }
+
+    /**
+     * @brief Encontra o maior código.
+     * @param codigo_max Recebe o código.
+     * @return false se a árvore estiver vazia.
+     */
+    bool maximo(int &codigo_max) const {
+        return extremo(codigo_max, true);
+    }
+
+    /**
+     * @brief Remove todos os códigos.
+     */
+    void limpa() {
+        limpa(raiz);
+        raiz = 0;
+        quantidade = 0;
+    }
+
+    /**
+     * @brief Retorna o número de códigos.
+     */
+    long long tamanho() const {
+        return quantidade;
+    }
+
+    /**
+     * @brief Retorna a memória ocupada pelos nós, em bytes (as folhas não ocupam memória própria).
+     */
+    size_t memoria() const {
+        return bytes;
+    }
+};
+
+/**
+ * @class FilaMPSC
+ * @brief Fila circular limitada, sem travas, com vários produtores e um único consumidor.
+ *
+ * @details Cada célula guarda um número de sequência que diz se ela está livre para o produtor da volta atual ou pronta para o consumidor. Os produtores disputam a cauda com compare-and-swap; o consumidor avança a cabeça sozinho, sem operações atômicas de leitura-modificação-escrita. Com um único produtor, a fila funciona como SPSC.
+ */
+template <typename T>
+class FilaMPSC
+{
+private:
+
+    struct Celula
+    {
+        std::atomic<size_t> sequencia;
+        T dado;
+    };
+
+    Celula *celulas;
+    size_t mascara;
+    char separador_cauda[64]; // Cauda e cabeça em linhas de cache distintas
+    std::atomic<size_t> cauda;
+    char separador_cabeca[64];
+    size_t cabeca;
+
+public:
+
+    /**
+     * @brief Construtor da fila.
+     * @param capacidade Número de células, arredondado para uma potência de 2.
+     */
+    FilaMPSC(size_t capacidade) : cauda(0), cabeca(0) {
+        size_t n = 2;
+        while (n < capacidade)
+            n *= 2;
+        celulas = new Celula[n];
+        mascara = n - 1;
+        for (size_t i = 0; i < n; i++)
+            celulas[i].sequencia.store(i, std::memory_order_relaxed);
+        (void) separador_cauda;
+        (void) separador_cabeca;
+    }
+
+    /**
+     * @brief Destrutor da fila.
+     */
+    ~FilaMPSC() {
+        delete[] celulas;
+    }
+
+    FilaMPSC(const FilaMPSC &) = delete;
+    FilaMPSC &operator=(const FilaMPSC &) = delete;
+
+    /**
+     * @brief Coloca um item na fila (qualquer thread).
+     * @param item O item.
+     * @return false se a fila estiver cheia.
+     */
+    bool coloca(const T &item) {
+        size_t pos = cauda.load(std::memory_order_relaxed);
+        Celula *c;
+        while (true) {
+            c = &celulas[pos & mascara];
+            size_t seq = c->sequencia.load(std::memory_order_acquire);
+            long dif = (long) seq - (long) pos;
+            if (dif == 0) {
+                if (cauda.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = cauda.load(std::memory_order_relaxed);
+            }
+        }
+        c->dado = item;
+        c->sequencia.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Retira um item da fila (somente a thread consumidora).
+     * @param item Recebe o item.
+     * @return false se a fila estiver vazia.
+     */
+    bool retira(T &item) {
+        Celula *c = &celulas[cabeca & mascara];
+        if (c->sequencia.load(std::memory_order_acquire) != cabeca + 1)
+            return false;
+        item = c->dado;
+        c->sequencia.store(cabeca + mascara + 1, std::memory_order_release);
+        cabeca++;
+        return true;
+    }
+};
+
+/**
+ * @class InventarioFragmentado
+ * @brief Inventário dividido por faixas de código entre threads, sem árvore compartilhada.
+ *
+ * @details Cada fragmento é dono de uma faixa contínua de códigos e tem sua própria árvore AVL, alterada apenas pela sua thread. Os pedidos chegam por uma fila MPSC sem travas; inserções e remoções são assíncronas, e inserções consecutivas são aplicadas em lote. Buscas por intervalo consultam só os fragmentos cuja faixa o intercepta, e os resultados saem ordenados porque as faixas são disjuntas e crescentes.
+ */
+class InventarioFragmentado
+{
+private:
+
+    enum TipoPedido { INSERE, REMOVE, BUSCA, INTERVALO, CONTA, BARREIRA, PARA };
+
+    struct Pedido
+    {
+        TipoPedido tipo;
+        int codigo;
+        int max;
+        long long *resultado;       // BUSCA e CONTA
+        std::vector<int> *destino;  // INTERVALO
+        std::atomic<int> *pendentes; // Pedidos síncronos: decrementado ao terminar
+    };
+
+    struct Fragmento
+    {
+        FilaMPSC<Pedido> fila;
+        AVL arvore;
+        std::thread trabalhador;
+
+        Fragmento(size_t capacidade) : fila(capacidade) {}
+    };
+
+    std::vector<Fragmento *> fragmentos;
+    std::vector<int> limites; // limites[i] é o primeiro código do fragmento i + 1
+
+    /**
+     * @brief Espera sem travas, cedendo o processador cada vez mais conforme a espera se prolonga.
+     * @param tentativas Número de esperas seguidas até aqui.
+     */
+    static void espera(int tentativas) {
+        if (tentativas < 64)
+            return;
+        if (tentativas < 1024)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+
+    /**
+     * @brief Aplica as inserções acumuladas de um fragmento.
+     * @param f O fragmento.
+     * @param lote Os códigos acumulados; é esvaziado.
+     */
+    static void aplica_insercoes(Fragmento *f, std::vector<int> &lote) {
+        if (lote.empty())
+            return;
+        ResultadoLote resultado;
+        f->arvore.insere_lote(lote, resultado);
+        lote.clear();
+    }
+
+    /**
+     * @brief Laço da thread dona de um fragmento.
+     * @param f O fragmento.
+     */
+    static void executa(Fragmento *f) {
+        std::vector<int> lote;
+        Pedido p;
+        int ociosas = 0;
+
+        while (true) {
+            if (!f->fila.retira(p)) {
+                // Fila vazia: aplica o que já chegou antes de esperar
+                aplica_insercoes(f, lote);
+                espera(ociosas++);
+                continue;
+            }
+            ociosas = 0;
+
+            if (p.tipo == INSERE) {
+                lote.push_back(p.codigo);
+                if (lote.size() >= 1024)
+                    aplica_insercoes(f, lote);
+                continue;
+            }
+
+            // Os demais pedidos precisam ver as inserções anteriores
+            aplica_insercoes(f, lote);
+
+            switch (p.tipo) {
+                case REMOVE:
+                    f->arvore.remove(p.codigo);
+                    break;
+                case BUSCA:
+                    *p.resultado = f->arvore.busca(p.codigo) != nullptr;
+                    break;
+                case INTERVALO:
+                    for (No *x = f->arvore.teto(p.codigo); x != nullptr && x->get_codigo() <= p.max; x = f->arvore.sucessor(x))
+                        p.destino->push_back(x->get_codigo());
+                    break;
+                case CONTA:
+                    *p.resultado = f->arvore.agrega_intervalo(p.codigo, p.max).itens;
+                    break;
+                default:
+                    break;
+            }
+
+            if (p.pendentes != nullptr)
+                p.pendentes->fetch_sub(1, std::memory_order_release);
+            if (p.tipo == PARA)
+                return;
+        }
+    }
+
+    /**
+     * @brief Retorna o fragmento dono de um código.
+     * @param codigo O código.
+     */
+    size_t fragmento_de(int codigo) const {
+        return std::upper_bound(limites.begin(), limites.end(), codigo) - limites.begin();
+    }
+
+    /**
+     * @brief Envia um pedido a um fragmento, esperando enquanto a fila estiver cheia.
+     * @param i O índice do fragmento.
+     * @param p O pedido.
+     */
+    void envia(size_t i, const Pedido &p) {
+        int tentativas = 0;
+        while (!fragmentos[i]->fila.coloca(p))
+            espera(64 + tentativas++);
+    }
+
+    /**
+     * @brief Espera até que todos os pedidos síncronos de uma operação terminem.
+     * @param pendentes O contador de pedidos da operação.
+     */
+    static void aguarda(std::atomic<int> &pendentes) {
+        int tentativas = 0;
+        while (pendentes.load(std::memory_order_acquire) > 0)
+            espera(tentativas++);
+    }
+
+    /**
+     * @brief Monta um pedido.
+     */
+    static Pedido pedido(TipoPedido tipo, int codigo = 0, int max = 0, std::atomic<int> *pendentes = nullptr) {
+        Pedido p;
+        p.tipo = tipo;
+        p.codigo = codigo;
+        p.max = max;
+        p.resultado = nullptr;
+        p.destino = nullptr;
+        p.pendentes = pendentes;
+        return p;
+    }
+
+public:
+
+    /**
+     * @brief Construtor do inventário, dividindo [min_codigo, max_codigo] em faixas de mesmo tamanho.
+     * 
+     * @details Códigos fora do intervalo vão para o primeiro ou para o último fragmento.
+     * @param num_fragmentos O número de fragmentos (e de threads).
+     * @param min_codigo O menor código esperado.
+     * @param max_codigo O maior código esperado.
+     * @param capacidade_fila O número de pedidos que cabem na fila de cada fragmento.
+     */
+    InventarioFragmentado(int num_fragmentos, int min_codigo, int max_codigo, size_t capacidade_fila = 1 << 16) {
+        if (num_fragmentos < 1)
+            num_fragmentos = 1;
+        double largura = ((double) max_codigo - min_codigo + 1) / num_fragmentos;
+        for (int i = 1; i < num_fragmentos; i++)
+            limites.push_back(min_codigo + (int) (largura * i));
+
+        for (int i = 0; i < num_fragmentos; i++)
+            fragmentos.push_back(new Fragmento(capacidade_fila));
+        for (size_t i = 0; i < fragmentos.size(); i++)
+            fragmentos[i]->trabalhador = std::thread(executa, fragmentos[i]);
+    }
+
+    /**
+     * @brief Destrutor: termina as threads depois de aplicar os pedidos pendentes.
+     */
+    ~InventarioFragmentado() {
+        std::atomic<int> pendentes((int) fragmentos.size());
+        for (size_t i = 0; i < fragmentos.size(); i++)
+            envia(i, pedido(PARA, 0, 0, &pendentes));
+        for (size_t i = 0; i < fragmentos.size(); i++) {
+            fragmentos[i]->trabalhador.join();
+            delete fragmentos[i];
+        }
+    }
+
+    InventarioFragmentado(const InventarioFragmentado &) = delete;
+    InventarioFragmentado &operator=(const InventarioFragmentado &) = delete;
+
+    /**
+     * @brief Retorna o número de fragmentos.
+     */
+    size_t num_fragmentos() const {
+        return fragmentos.size();
+    }
+
+    /**
+     * @brief Insere um código, sem esperar pela sua aplicação. Códigos já presentes são ignorados.
+     * @param codigo O código.
+     */
+    void insere(int codigo) {
+        envia(fragmento_de(codigo), pedido(INSERE, codigo));
+    }
+
+    /**
+     * @brief Remove um código, sem esperar pela sua aplicação.
+     * @param codigo O código.
+     */
+    void remove(int codigo) {
+        envia(fragmento_de(codigo), pedido(REMOVE, codigo));
+    }
+
+    /**
+     * @brief Espera até que todos os pedidos enviados antes tenham sido aplicados.
+     */
+    void sincroniza() {
+        std::atomic<int> pendentes((int) fragmentos.size());
+        for (size_t i = 0; i < fragmentos.size(); i++)
+            envia(i, pedido(BARREIRA, 0, 0, &pendentes));
+        aguarda(pendentes);
+    }
+
+    /**
+     * @brief Verifica se um código está no inventário.
+     * @param codigo O código.
+     * @return true se o código estiver presente.
+     */
+    bool busca(int codigo) {
+        std::atomic<int> pendentes(1);
+        long long achado = 0;
+        Pedido p = pedido(BUSCA, codigo, 0, &pendentes);
+        p.resultado = &achado;
+        envia(fragmento_de(codigo), p);
+        aguarda(pendentes);
+        return achado != 0;
+    }
+
+    /**
+     * @brief Retorna, em ordem, os códigos de um intervalo, consultando só os fragmentos que o interceptam.
+     * @param min O menor código do intervalo.
+     * @param max O maior código do intervalo.
+     */
+    std::vector<int> busca_intervalo(int min, int max) {
+        std::vector<int> codigos;
+        if (min > max)
+            return codigos;
+
+        size_t primeiro = fragmento_de(min), ultimo = fragmento_de(max);
+        std::vector<std::vector<int> > partes(ultimo - primeiro + 1);
+        std::atomic<int> pendentes((int) partes.size());
+        for (size_t i = primeiro; i <= ultimo; i++) {
+            Pedido p = pedido(INTERVALO, min, max, &pendentes);
+            p.destino = &partes[i - primeiro];
+            envia(i, p);
+        }
+        aguarda(pendentes);
+
+        for (size_t i = 0; i < partes.size(); i++)
+            codigos.insert(codigos.end(), partes[i].begin(), partes[i].end());
+        return codigos;
+    }
+
+    /**
+     * @brief Conta os códigos de um intervalo, consultando só os fragmentos que o interceptam.
+     * @param min O menor código do intervalo.
+     * @param max O maior código do intervalo.
+     */
+    long long conta_intervalo(int min, int max) {
+        if (min > max)
+            return 0;
+
+        size_t primeiro = fragmento_de(min), ultimo = fragmento_de(max);
+        std::vector<long long> contagens(ultimo - primeiro + 1, 0);
+        std::atomic<int> pendentes((int) contagens.size());
+        for (size_t i = primeiro; i <= ultimo; i++) {
+            Pedido p = pedido(CONTA, min, max, &pendentes);
+            p.resultado = &contagens[i - primeiro];
+            envia(i, p);
+        }
+        aguarda(pendentes);
+
+        long long total = 0;
+        for (size_t i = 0; i < contagens.size(); i++)
+            total += contagens[i];
+        return total;
+    }
+
+    /**
+     * @brief Conta todos os códigos do inventário.
+     */
+    long long tamanho() {
+        return conta_intervalo(INT_MIN, INT_MAX);
+    }
+};
+
+/**
+ * @class InventarioLSM
+ * @brief Inventário otimizado para escrita, no estilo LSM: um buffer pequeno e corridas ordenadas imutáveis.
+ *
+ * @details Inserções e remoções vão para um buffer de duas árvores radix pequenas (inseridos e marcas de remoção), que cabem no cache. Quando o buffer enche, ele é descarregado como uma corrida ordenada de nível 0, que nunca mais muda. Uma thread de fundo intercala as corridas por níveis: quando um nível junta `corridas_por_nivel` corridas, elas viram uma só corrida do nível seguinte, e só corridas de tamanhos parecidos são intercaladas. Assim cada entrada é regravada uma vez por nível, cerca de log(n / tam_buffer) / log(corridas_por_nivel) vezes. As marcas de remoção só são descartadas quando a corrida mais antiga entra na intercalação. Se um nível chegar ao dobro do limite, as escritas esperam a intercalação. Buscas consultam o buffer e as corridas da mais nova para a mais antiga, e a primeira que tiver o código decide. Um `corridas_por_nivel` maior barateia as escritas e encarece as leituras. Ao contrário da AVL, cada código aparece no máximo uma vez. As operações devem ser feitas por uma única thread.
+ */
+class InventarioLSM
+{
+private:
+
+    struct Entrada
+    {
+        int codigo;
+        bool removido; // Marca de remoção: esconde o código nas corridas mais antigas
+
+        bool operator<(const Entrada &e) const { return codigo < e.codigo; }
+    };
+
+    typedef std::vector<Entrada> Corrida;
+    typedef std::pair<const Entrada *, const Entrada *> Trecho;
+
+    ArvoreRadix insercoes;
+    ArvoreRadix remocoes;
+    size_t no_buffer;
+    size_t tam_buffer;
+    size_t corridas_por_nivel;
+
+    std::vector<std::shared_ptr<const Corrida>> corridas; // Da mais nova para a mais antiga
+    std::vector<int> niveis; // Nível de cada corrida; não diminui da mais nova para a mais antiga
+    std::mutex trava;
+    std::condition_variable sinal;
+    bool parar;
+    long long intercalacoes;
+    long long entradas_descarregadas;
+    long long entradas_gravadas; // Descarregadas e regravadas pelas intercalações
+    std::thread intercalador;
+
+    /**
+     * @brief Intercala trechos ordenados, mantendo de cada código só a entrada do trecho mais novo.
+     * @param trechos Os trechos, do mais novo para o mais antigo.
+     * @param descarta_marcas Se true, as marcas de remoção não vão para a saída.
+     * @param saida Recebe as entradas, em ordem.
+     */
+    static void intercala(std::vector<Trecho> trechos, bool descarta_marcas, Corrida &saida) {
+        // Heap de mínimo por (código, idade do trecho): entre códigos iguais sai primeiro o mais novo
+        typedef std::pair<int, size_t> Item;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> heap;
+        for (size_t i = 0; i < trechos.size(); i++)
+            if (trechos[i].first != trechos[i].second)
+                heap.push(Item(trechos[i].first->codigo, i));
+
+        bool primeiro = true;
+        int ultimo = 0;
+        while (!heap.empty()) {
+            size_t i = heap.top().second;
+            heap.pop();
+            const Entrada &e = *trechos[i].first++;
+            if (trechos[i].first != trechos[i].second)
+                heap.push(Item(trechos[i].first->codigo, i));
+
+            if (!primeiro && e.codigo == ultimo)
+                continue;
+            primeiro = false;
+            ultimo = e.codigo;
+            if (!e.removido || !descarta_marcas)
+                saida.push_back(e);
+        }
+    }
+
+    /**
+     * @brief Retorna o trecho de uma corrida com os códigos em [min, max].
+     */
+    static Trecho trecho(const Corrida &c, int min, int max) {
+        Entrada a = {min, false}, b = {max, false};
+        const Entrada *ini = c.data(), *fim = c.data() + c.size();
+        return Trecho(std::lower_bound(ini, fim, a), std::upper_bound(ini, fim, b));
+    }
+
+    /**
+     * @brief Monta uma corrida com as entradas do buffer em [min, max].
+     * @param saida Recebe as entradas, em ordem.
+     */
+    void copia_buffer(int min, int max, Corrida &saida) {
+        std::vector<int> x, y;
+        insercoes.busca_intervalo(min, max, x);
+        remocoes.busca_intervalo(min, max, y);
+
+        // Um código nunca está nas duas árvores do buffer
+        size_t i = 0, j = 0;
+        while (i < x.size() || j < y.size()) {
+            bool insercao = j == y.size() || (i < x.size() && x[i] < y[j]);
+            Entrada e = {insercao ? x[i++] : y[j++], !insercao};
+            saida.push_back(e);
+        }
+    }
+
+    /**
+     * @brief Copia a lista de corridas atual.
+     */
+    std::vector<std::shared_ptr<const Corrida>> corridas_atuais() {
+        std::lock_guard<std::mutex> l(trava);
+        return corridas;
+    }
+
+    /**
+     * @brief Procura o nível mais baixo com corridas suficientes para uma intercalação (com a trava).
+     * @param ini Recebe a posição da primeira corrida do nível.
+     * @param fim Recebe a posição seguinte à última.
+     * @return false se nenhum nível precisar de intercalação.
+     */
+    bool acha_grupo(size_t &ini, size_t &fim) const {
+        // As corridas de um mesmo nível são vizinhas
+        for (ini = 0; ini < corridas.size(); ini = fim) {
+            for (fim = ini + 1; fim < corridas.size() && niveis[fim] == niveis[ini]; fim++);
+            if (fim - ini >= corridas_por_nivel)
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Retorna o maior número de corridas num mesmo nível (com a trava).
+     */
+    size_t mais_cheio() const {
+        size_t maior = 0;
+        for (size_t ini = 0, fim; ini < corridas.size(); ini = fim) {
+            for (fim = ini + 1; fim < corridas.size() && niveis[fim] == niveis[ini]; fim++);
+            maior = std::max(maior, fim - ini);
+        }
+        return maior;
+    }
+
+    /**
+     * @brief Laço da thread de intercalação.
+     */
+    void executa() {
+        std::unique_lock<std::mutex> l(trava);
+        while (true) {
+            size_t ini = 0, fim = 0;
+            sinal.wait(l, [&]() { return parar || acha_grupo(ini, fim); });
+            if (parar)
+                return;
+
+            // Intercala sem a trava; enquanto isso, novas corridas só podem entrar na frente,
+            // então a posição do grupo é guardada a partir do fim
+            size_t depois = corridas.size() - fim;
+            int nivel = niveis[ini] + 1;
+            std::vector<std::shared_ptr<const Corrida>> grupo(corridas.begin() + ini, corridas.begin() + fim);
+            l.unlock();
+
+            std::vector<Trecho> trechos;
+            for (size_t i = 0; i < grupo.size(); i++)
+                trechos.push_back(Trecho(grupo[i]->data(), grupo[i]->data() + grupo[i]->size()));
+            std::shared_ptr<Corrida> nova = std::make_shared<Corrida>();
+            intercala(trechos, depois == 0, *nova);
+            l.lock();
+
+            fim = corridas.size() - depois;
+            ini = fim - grupo.size();
+            corridas.erase(corridas.begin() + ini, corridas.begin() + fim);
+            niveis.erase(niveis.begin() + ini, niveis.begin() + fim);
+            if (!nova->empty()) {
+                corridas.insert(corridas.begin() + ini, nova);
+                niveis.insert(niveis.begin() + ini, nivel);
+            }
+            intercalacoes++;
+            entradas_gravadas += nova->size();
+            sinal.notify_all();
+        }
+    }
+
+public:
+
+    /**
+     * @brief Construtor do inventário LSM vazio.
+     * @param tam_buffer Número de entradas do buffer antes de descarregá-lo numa corrida.
+     * @param corridas_por_nivel Número de corridas de um nível que são intercaladas numa do nível seguinte (pelo menos 2; limita o custo das buscas).
+     */
+    InventarioLSM(size_t tam_buffer = 65536, size_t corridas_por_nivel = 4) :
+        no_buffer(0),
+        tam_buffer(tam_buffer > 0 ? tam_buffer : 1),
+        corridas_por_nivel(corridas_por_nivel > 2 ? corridas_por_nivel : 2),
+        parar(false),
+        intercalacoes(0),
+        entradas_descarregadas(0),
+        entradas_gravadas(0)
+    {
+        intercalador = std::thread(&InventarioLSM::executa, this);
+    }
+
+    /**
+     * @brief Destrutor do inventário LSM: para a thread de intercalação.
+     */
+    ~InventarioLSM() {
+        {
+            std::lock_guard<std::mutex> l(trava);
+            parar = true;
+        }
+        sinal.notify_all();
+        intercalador.join();
+    }
+
+    InventarioLSM(const InventarioLSM &) = delete;
+    InventarioLSM &operator=(const InventarioLSM &) = delete;
+
+    /**
+     * @brief Insere um código (sem efeito se ele já estiver presente).
+     * @param codigo O código.
+     */
+    void insere(int codigo) {
+        no_buffer -= remocoes.remove(codigo);
+        no_buffer += insercoes.insere(codigo);
+        if (no_buffer >= tam_buffer)
+            descarrega();
+    }
+
+    /**
+     * @brief Remove um código (sem efeito se ele não estiver presente).
+     * @param codigo O código.
+     */
+    void remove(int codigo) {
+        no_buffer -= insercoes.remove(codigo);
+        no_buffer += remocoes.insere(codigo);
+        if (no_buffer >= tam_buffer)
+            descarrega();
+    }
+
+    /**
+     * @brief Descarrega o buffer numa nova corrida, esperando se algum nível estiver no dobro do limite.
+     */
+    void descarrega() {
+        if (no_buffer == 0)
+            return;
+
+        std::shared_ptr<Corrida> nova = std::make_shared<Corrida>();
+        nova->reserve(no_buffer);
+        copia_buffer(INT_MIN, INT_MAX, *nova);
+        insercoes.limpa();
+        remocoes.limpa();
+        no_buffer = 0;
+
+        std::unique_lock<std::mutex> l(trava);
+        sinal.wait(l, [this]() { return mais_cheio() < 2 * corridas_por_nivel; });
+        corridas.insert(corridas.begin(), nova);
+        niveis.insert(niveis.begin(), 0);
+        entradas_descarregadas += nova->size();
+        entradas_gravadas += nova->size();
+        sinal.notify_all();
+    }
+
+    /**
+     * @brief Espera até que nenhum nível precise de intercalação.
+     */
+    void aguarda_intercalacao() {
+        std::unique_lock<std::mutex> l(trava);
+        size_t ini, fim;
+        sinal.wait(l, [&]() { return !acha_grupo(ini, fim); });
+    }
+
+    /**
+     * @brief Verifica se um código está presente, consultando o buffer e as corridas da mais nova para a mais antiga.
+     * @param codigo O código.
+     */
+    bool busca(int codigo) {
+        if (insercoes.busca(codigo))
+            return true;
+        if (remocoes.busca(codigo))
+            return false;
+
+        std::vector<std::shared_ptr<const Corrida>> atuais = corridas_atuais();
+        Entrada e = {codigo, false};
+        for (size_t i = 0; i < atuais.size(); i++) {
+            Corrida::const_iterator it = std::lower_bound(atuais[i]->begin(), atuais[i]->end(), e);
+            if (it != atuais[i]->end() && it->codigo == codigo)
+                return !it->removido;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Acrescenta a um vetor, em ordem, os códigos presentes em [min, max].
+     * @param min O menor código do intervalo.
+     * @param max O maior código do intervalo.
+     * @param saida O vetor de saída.
+     */
+    void busca_intervalo(int min, int max, std::vector<int> &saida) {
+        if (min > max)
+            return;
+
+        Corrida buffer, resultado;
+        copia_buffer(min, max, buffer);
+        std::vector<std::shared_ptr<const Corrida>> atuais = corridas_atuais();
+
+        std::vector<Trecho> trechos;
+        trechos.push_back(Trecho(buffer.data(), buffer.data() + buffer.size()));
+        for (size_t i = 0; i < atuais.size(); i++)
+            trechos.push_back(trecho(*atuais[i], min, max));
+        intercala(trechos, true, resultado);
+
+        for (size_t i = 0; i < resultado.size(); i++)
+            saida.push_back(resultado[i].codigo);
+    }
+
+    /**
+     * @brief Retorna o número de corridas atuais.
+     */
+    size_t get_corridas() {
+        std::lock_guard<std::mutex> l(trava);
+        return corridas.size();
+    }
+
+    /**
+     * @brief Retorna o número de intercalações feitas pela thread de fundo.
+     */
+    long long get_intercalacoes() {
+        std::lock_guard<std::mutex> l(trava);
+        return intercalacoes;
+    }
+
+    /**
+     * @brief Retorna a amplificação de escrita: entradas gravadas em corridas (na descarga e nas intercalações) por entrada descarregada.
+     */
+    double get_amplificacao() {
+        std::lock_guard<std::mutex> l(trava);
+        return entradas_descarregadas > 0 ? (double) entradas_gravadas / entradas_descarregadas : 0;
+    }
+};
+
+/**
+ * @brief Tamanho, em bytes, de uma página do índice em disco.
+ */
+#define TAM_PAGINA 4096
+
+/**
+ * @class Pagina
+ * @brief Página de tamanho fixo do índice em disco.
+ *
+ * @details A página é um bloco bruto de TAM_PAGINA bytes. Os primeiros 16 bytes formam o cabeçalho (tipo, número de chaves e, nas folhas, a próxima folha); o restante guarda as chaves e, nas páginas internas, os identificadores das páginas filhas.
+ */
+struct Pagina
+{
+    // Capacidade de chaves de uma folha e de uma página interna
+    static const int CAP_FOLHA = (TAM_PAGINA - 16) / 4;
+    static const int CAP_INTERNA = (TAM_PAGINA - 16 - 12) / 12;
+
+    int32_t folha;
+    int32_t n;
+    int64_t proxima;
+    char dados[TAM_PAGINA - 16];
+
+    /**
+     * @brief Retorna o vetor de chaves da página.
+     */
+    inline int32_t *chaves() {
+        return reinterpret_cast<int32_t *>(dados);
+    }
+
+    /**
+     * @brief Retorna o vetor de páginas filhas (apenas páginas internas).
+     */
+    inline int64_t *filhos() {
+        return reinterpret_cast<int64_t *>(dados + 4 * (CAP_INTERNA + 1));
+    }
+
+    /**
+     * @brief Retorna o índice do primeiro elemento maior que k.
+     * @param k A chave procurada.
+     */
+    inline int posicao(int k) {
+        return std::upper_bound(chaves(), chaves() + n, k) - chaves();
+    }
+};
+
+/**
+ * @class CachePaginas
+ * @brief Cache limitado de páginas de um arquivo, com despejo LRU.
+ *
+ * @details Mantém no máximo `capacidade` páginas em memória. Páginas alteradas só são gravadas no arquivo quando despejadas ou no descarregamento final.
+ */
+class CachePaginas
+{
+private:
+
+    struct Quadro {
+        int64_t id;
+        bool suja;
+        Pagina pagina;
+    };
+
+    FILE *arquivo;
+    size_t capacidade;
+    int64_t num_paginas;
+
+    // Quadros em ordem de uso (mais recente na frente)
+    std::list<Quadro> quadros;
+    std::unordered_map<int64_t, std::list<Quadro>::iterator> mapa;
+
+    // Contadores
+    long long acertos;
+    long long faltas;
+    long long despejos;
+    long long gravacoes;
+
+    /**
+     * @brief Grava um quadro no arquivo.
+     * @param q Quadro a ser gravado.
+     */
+    void grava_disco(const Quadro &q) {
+        if (fseeko(arquivo, (off_t) q.id * TAM_PAGINA, SEEK_SET) != 0 ||
+            fwrite(&q.pagina, TAM_PAGINA, 1, arquivo) != 1)
+        {
+            std::cerr << "Erro de escrita no índice (página " << q.id << ")\n";
+            exit(EXIT_FAILURE);
+        }
+        gravacoes++;
+    }
+
+    /**
+     * @brief Traz uma página para a frente do cache, lendo-a do disco se preciso.
+     * @param id Identificador da página.
+     * @return Referência para o quadro da página.
+     */
+    Quadro &carrega(int64_t id) {
+        auto it = mapa.find(id);
+        if (it != mapa.end()) {
+            acertos++;
+            quadros.splice(quadros.begin(), quadros, it->second);
+            return quadros.front();
+        }
+
+        faltas++;
+        if (quadros.size() >= capacidade) {
+            // Despeja a página usada há mais tempo
+            Quadro &velho = quadros.back();
+            if (velho.suja)
+                grava_disco(velho);
+            mapa.erase(velho.id);
+            quadros.pop_back();
+            despejos++;
+        }
+
+        quadros.emplace_front();
+        Quadro &q = quadros.front();
+        q.id = id;
+        q.suja = false;
+        if (fseeko(arquivo, (off_t) id * TAM_PAGINA, SEEK_SET) != 0 ||
+            fread(&q.pagina, TAM_PAGINA, 1, arquivo) != 1)
+        {
+            std::cerr << "Erro de leitura no índice (página " << id << ")\n";
+            exit(EXIT_FAILURE);
+        }
+        mapa[id] = quadros.begin();
+        return q;
+    }
+
+public:
+
+    /**
+     * @brief Construtor do cache.
+     * @param arquivo Arquivo aberto para leitura e escrita.
+     * @param capacidade Número máximo de páginas em memória.
+     * @param num_paginas Número de páginas já existentes no arquivo.
+     */
+    CachePaginas(FILE *arquivo, size_t capacidade, int64_t num_paginas) :
+        arquivo(arquivo),
+        capacidade(capacidade < 4 ? 4 : capacidade),
+        num_paginas(num_paginas),
+        acertos(0),
+        faltas(0),
+        despejos(0),
+        gravacoes(0)
+    {}
+
+    /**
+     * @brief Copia uma página do cache.
+     * @param id Identificador da página.
+     * @param p Página de destino.
+     */
+    void le(int64_t id, Pagina &p) {
+        p = carrega(id).pagina;
+    }
+
+    /**
+     * @brief Atualiza uma página no cache, marcando-a como suja.
+     * @param id Identificador da página.
+     * @param p Novo conteúdo da página.
+     */
+    void grava(int64_t id, const Pagina &p) {
+        Quadro &q = carrega(id);
+        q.pagina = p;
+        q.suja = true;
+    }
+
+    /**
+     * @brief Aloca uma nova página no fim do arquivo.
+     * @return Identificador da nova página.
+     */
+    int64_t nova() {
+        Quadro q;
+        q.id = num_paginas++;
+        q.suja = false;
+        memset(&q.pagina, 0, TAM_PAGINA);
+        grava_disco(q);
+        return q.id;
+    }
+
+    /**
+     * @brief Grava todas as páginas sujas no arquivo.
+     */
+    void descarrega() {
+        for (Quadro &q : quadros)
+            if (q.suja) {
+                grava_disco(q);
+                q.suja = false;
+            }
+        fflush(arquivo);
+    }
+
+    int64_t get_num_paginas() const { return num_paginas; }
+    long long get_acertos() const { return acertos; }
+    long long get_faltas() const { return faltas; }
+    long long get_despejos() const { return despejos; }
+    long long get_gravacoes() const { return gravacoes; }
+
+    /**
+     * @brief Retorna a taxa de acerto do cache, entre 0 e 1.
+     */
+    double taxa_acerto() const {
+        long long total = acertos + faltas;
+        return total ? (double) acertos / total : 0.0;
+    }
+};
+
+/**
+ * @class ArvorePaginada
+ * @brief Índice ordenado de códigos armazenado em disco (árvore B+).
+ *
+ * @details Os nós são páginas de tamanho fixo em um único arquivo, acessadas através de um CachePaginas limitado. Assim, o inventário pode ser muito maior que a memória disponível. A página 0 guarda os metadados (raiz, número de páginas e de códigos). As folhas são encadeadas para a busca em intervalo.
+ * @details A remoção não funde páginas: folhas que ficam vazias permanecem na árvore e são reaproveitadas por inserções futuras no mesmo intervalo.
+ */
+class ArvorePaginada
+{
+private:
+
+    static const uint32_t ASSINATURA = 0x41564C50; // "AVLP"
+
+    FILE *arquivo;
+    CachePaginas *cache;
+    int64_t raiz;
+    long long quantidade;
+
+    /**
+     * @brief Desce da raiz até a folha que deveria conter k.
+     * @param k A chave procurada.
+     * @param caminho Se não nulo, recebe as páginas internas visitadas.
+     * @return Identificador da folha.
+     */
+    int64_t desce(int k, std::vector<int64_t> *caminho = nullptr) {
+        Pagina p;
+        int64_t id = raiz;
+        cache->le(id, p);
+        while (!p.folha) {
+            if (caminho)
+                caminho->push_back(id);
+            id = p.filhos()[p.posicao(k)];
+            cache->le(id, p);
+        }
+        return id;
+    }
+
+    /**
+     * @brief Insere um separador e a página à sua direita nas páginas internas do caminho, dividindo-as se preciso.
+     * @param caminho Páginas internas visitadas na descida.
+     * @param chave O separador.
+     * @param direita A página nova à direita do separador.
+     */
+    void sobe_separador(std::vector<int64_t> &caminho, int chave, int64_t direita) {
+        Pagina p;
+        while (!caminho.empty()) {
+            int64_t id = caminho.back();
+            caminho.pop_back();
+            cache->le(id, p);
+
+            // Vetores temporários com uma posição extra
+            std::vector<int32_t> ch(p.chaves(), p.chaves() + p.n);
+            std::vector<int64_t> fi(p.filhos(), p.filhos() + p.n + 1);
+            int i = p.posicao(chave);
+            ch.insert(ch.begin() + i, chave);
+            fi.insert(fi.begin() + i + 1, direita);
+
+            if ((int) ch.size() <= Pagina::CAP_INTERNA) {
+                p.n = ch.size();
+                std::copy(ch.begin(), ch.end(), p.chaves());
+                std::copy(fi.begin(), fi.end(), p.filhos());
+                cache->grava(id, p);
+                return;
+            }
+
+            // Divide a página: a chave do meio sobe
+            int meio = ch.size() / 2;
+            Pagina q;
+            memset(&q, 0, TAM_PAGINA);
+            q.folha = 0;
+            q.proxima = -1;
+            q.n = ch.size() - meio - 1;
+            std::copy(ch.begin() + meio + 1, ch.end(), q.chaves());
+            std::copy(fi.begin() + meio + 1, fi.end(), q.filhos());
+
+            p.n = meio;
+            std::copy(ch.begin(), ch.begin() + meio, p.chaves());
+            std::copy(fi.begin(), fi.begin() + meio + 1, p.filhos());
+
+            chave = ch[meio];
+            direita = cache->nova();
+            cache->grava(id, p);
+            cache->grava(direita, q);
+        }
+
+        // A raiz foi dividida: cria uma nova raiz
+        Pagina r;
+        memset(&r, 0, TAM_PAGINA);
+        r.folha = 0;
+        r.proxima = -1;
+        r.n = 1;
+        r.chaves()[0] = chave;
+        r.filhos()[0] = raiz;
+        r.filhos()[1] = direita;
+        int64_t nova_raiz = cache->nova();
+        cache->grava(nova_raiz, r);
+        raiz = nova_raiz;
+    }
+
+    /**
+     * @brief Encontra o menor ou o maior código de uma subárvore, ignorando folhas vazias.
+     * @param id Página de onde a busca começa.
+     * @param maior true para o máximo, false para o mínimo.
+     * @param k Recebe o código encontrado.
+     * @return false se a subárvore não tiver códigos.
+     */
+    bool extremo(int64_t id, bool maior, int &k) {
+        Pagina p;
+        cache->le(id, p);
+        if (p.folha) {
+            if (p.n == 0)
+                return false;
+            k = maior ? p.chaves()[p.n - 1] : p.chaves()[0];
+            return true;
+        }
+
+        std::vector<int64_t> fi(p.filhos(), p.filhos() + p.n + 1);
+        if (maior)
+            std::reverse(fi.begin(), fi.end());
+        for (int64_t f : fi)
+            if (extremo(f, maior, k))
+                return true;
+        return false;
+    }
+
+    /**
+     * @brief Grava os metadados na página 0.
+     */
+    void grava_cabecalho() {
+        Pagina p;
+        memset(&p, 0, TAM_PAGINA);
+        int64_t *meta = reinterpret_cast<int64_t *>(p.dados);
+        p.folha = ASSINATURA;
+        meta[0] = raiz;
+        meta[1] = quantidade;
+        cache->grava(0, p);
+    }
+
+public:
+
+    /**
+     * @brief Abre (ou cria) um índice em disco.
+     * @param nome_arquivo Caminho do arquivo do índice.
+     * @param paginas_cache Número máximo de páginas mantidas em memória.
+     */
+    ArvorePaginada(const char *nome_arquivo, size_t paginas_cache = 1024) {
+        arquivo = fopen(nome_arquivo, "r+b");
+        bool novo = arquivo == NULL;
+        if (novo)
+            arquivo = fopen(nome_arquivo, "w+b");
+        if (arquivo == NULL)
+        {
+            std::cerr << "Erro ao abrir o arquivo: " << nome_arquivo << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        fseeko(arquivo, 0, SEEK_END);
+        int64_t num_paginas = ftello(arquivo) / TAM_PAGINA;
+        cache = new CachePaginas(arquivo, paginas_cache, novo ? 0 : num_paginas);
+
+        if (novo || num_paginas == 0) {
+            // Página 0: metadados; página 1: folha raiz vazia
+            cache->nova();
+            raiz = cache->nova();
+            Pagina f;
+            memset(&f, 0, TAM_PAGINA);
+            f.folha = 1;
+            f.proxima = -1;
+            cache->grava(raiz, f);
+            quantidade = 0;
+            grava_cabecalho();
+        } else {
+            Pagina p;
+            cache->le(0, p);
+            if ((uint32_t) p.folha != ASSINATURA) {
+                std::cerr << "Arquivo de índice inválido: " << nome_arquivo << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            int64_t *meta = reinterpret_cast<int64_t *>(p.dados);
+            raiz = meta[0];
+            quantidade = meta[1];
+        }
+    }
+
+    /**
+     * @brief Destrutor: grava as páginas pendentes e fecha o arquivo.
+     */
+    ~ArvorePaginada() {
+        descarrega();
+        delete cache;
+        fclose(arquivo);
+    }
+
+    ArvorePaginada(const ArvorePaginada &) = delete;
+    ArvorePaginada &operator=(const ArvorePaginada &) = delete;
+
+    /**
+     * @brief Grava no arquivo os metadados e todas as páginas alteradas.
+     */
+    void descarrega() {
+        grava_cabecalho();
+        cache->descarrega();
+    }
+
+    /**
+     * @brief Busca um código no índice.
+     * @param k O código a ser buscado.
+     * @return true se o código está no índice, false caso contrário.
+     */
+    bool busca(int k) {
+        Pagina p;
+        cache->le(desce(k), p);
+        return std::binary_search(p.chaves(), p.chaves() + p.n, k);
+    }
+
+    /**
+     * @brief Insere um código no índice.
+     * @param k O código a ser inserido.
+     * @return true se o código foi inserido, false se já existia.
+     */
+    bool insere(int k) {
+        std::vector<int64_t> caminho;
+        int64_t id = desce(k, &caminho);
+
+        Pagina p;
+        cache->le(id, p);
+        int32_t *pos = std::lower_bound(p.chaves(), p.chaves() + p.n, k);
+        if (pos != p.chaves() + p.n && *pos == k)
+            return false;
+        quantidade++;
+
+        if (p.n < Pagina::CAP_FOLHA) {
+            std::copy_backward(pos, p.chaves() + p.n, p.chaves() + p.n + 1);
+            *pos = k;
+            p.n++;
+            cache->grava(id, p);
+            return true;
+        }
+
+        // Folha cheia: divide em duas metades
+        std::vector<int32_t> ch(p.chaves(), p.chaves() + p.n);
+        ch.insert(ch.begin() + (pos - p.chaves()), k);
+        int meio = ch.size() / 2;
+
+        Pagina q;
+        memset(&q, 0, TAM_PAGINA);
+        q.folha = 1;
+        q.n = ch.size() - meio;
+        q.proxima = p.proxima;
+        std::copy(ch.begin() + meio, ch.end(), q.chaves());
+        int64_t direita = cache->nova();
+
+        p.n = meio;
+        p.proxima = direita;
+        std::copy(ch.begin(), ch.begin() + meio, p.chaves());
+        cache->grava(id, p);
+        cache->grava(direita, q);
+
+        sobe_separador(caminho, q.chaves()[0], direita);
+        return true;
+    }
+
+    /**
+     * @brief Remove um código do índice.
+     * @param k O código a ser removido.
+     * @return true se o código foi removido, false caso contrário.
+     */
+    bool remove(int k) {
+        int64_t id = desce(k);
+        Pagina p;
+        cache->le(id, p);
+        int32_t *pos = std::lower_bound(p.chaves(), p.chaves() + p.n, k);
+        if (pos == p.chaves() + p.n || *pos != k)
+            return false;
+
+        std::copy(pos + 1, p.chaves() + p.n, pos);
+        p.n--;
+        cache->grava(id, p);
+        quantidade--;
+        return true;
+    }
+
+    /**
+     * @brief Percorre os códigos dentro de um intervalo em ordem crescente.
+     * @param min O valor mínimo da chave.
+     * @param max O valor máximo da chave.
+     * @param visita Função chamada para cada código do intervalo.
+     * @return Número de códigos visitados.
+     */
+    template <typename F>
+    long long percorre_intervalo(int min, int max, F visita) {
+        long long total = 0;
+        Pagina p;
+        int64_t id = desce(min);
+        while (id != -1) {
+            cache->le(id, p);
+            int i = std::lower_bound(p.chaves(), p.chaves() + p.n, min) - p.chaves();
+            for (; i < p.n; i++) {
+                if (p.chaves()[i] > max)
+                    return total;
+                visita(p.chaves()[i]);
+                total++;
+            }
+            id = p.proxima;
+        }
+        return total;
+    }
+
+    /**
+     * @brief Busca elementos dentro de um intervalo de chaves e os escreve na saída padrão.
+     * @param min O valor mínimo da chave.
+     * @param max O valor máximo da chave.
+     */
+    void busca_intervalo(int min, int max) {
+        percorre_intervalo(min, max, [](int k) { std::cout << k << "\n"; });
+    }
+
+    /**
+     * @brief Encontra o menor código do índice.
+     * @param k Recebe o código mínimo.
+     * @return false se o índice estiver vazio.
+     */
+    bool minimo(int &k) {
+        return extremo(raiz, false, k);
+    }
+
+    /**
+     * @brief Encontra o maior código do índice.
+     * @param k Recebe o código máximo.
+     * @return false se o índice estiver vazio.
+     */
+    bool maximo(int &k) {
+        return extremo(raiz, true, k);
+    }
+
+    /**
+     * @brief Retorna o número de códigos no índice.
+     */
+    long long tamanho() const {
+        return quantidade;
+    }
+
+    /**
+     * @brief Retorna o cache de páginas, para consulta dos contadores.
+     */
+    const CachePaginas &get_cache() const {
+        return *cache;
+    }
+
+    /**
+     * @brief Escreve as estatísticas do cache de páginas na saída padrão.
+     */
+    void escreve_estatisticas() const {
+        std::cout << "Códigos no índice: " << quantidade << "\n"
+                  << "Páginas no arquivo: " << cache->get_num_paginas() << "\n"
+                  << "Acertos no cache: " << cache->get_acertos() << "\n"
+                  << "Faltas no cache: " << cache->get_faltas() << "\n"
+                  << "Despejos: " << cache->get_despejos() << "\n"
+                  << "Gravações em disco: " << cache->get_gravacoes() << "\n"
+                  << std::fixed << std::setprecision(2)
+                  << "Taxa de acerto: " << 100.0 * cache->taxa_acerto() << "%\n";
+    }
+};
+
+/**
+ * @brief Tamanho, em bytes, de um pedido do protocolo binário: operação (1), código (4) e máximo (4).
+ */
+#define TAM_PEDIDO 9
+
+/**
+ * @brief Tamanho, em bytes, do cabeçalho de uma resposta: situação (1) e quantidade (4).
+ */
+#define TAM_RESPOSTA 5
+
+/**
+ * @brief Operações do protocolo binário. Inteiros vão na ordem de bytes da máquina, já que cliente e servidor são locais.
+ *
+ * @details Toda resposta começa com a situação (1 se o código foi achado, inserido ou removido; 0 caso contrário) e uma quantidade. Em OP_INTERVALO a quantidade é o número de códigos que seguem o cabeçalho; em OP_CONTA é a contagem, sem códigos.
+ */
+enum OperacaoProtocolo
+{
+    OP_BUSCA = 'B',
+    OP_INSERE = 'I',
+    OP_REMOVE = 'R',
+    OP_INTERVALO = 'V',
+    OP_CONTA = 'C'
+};
+
+/**
+ * @brief Indica se o servidor deve continuar; zerada por SIGINT ou SIGTERM.
+ */
+static volatile sig_atomic_t servidor_ativo = 1;
+
+/**
+ * @brief Trata SIGINT e SIGTERM, pedindo o fim do laço do servidor.
+ */
+void para_servidor(int)
+{
+    servidor_ativo = 0;
+}
+
+/**
+ * @brief Abre um socket local, escutando nele ou conectando-se a ele.
+ * 
+ * @details Um endereço só com dígitos é uma porta TCP em 127.0.0.1; qualquer outro é o caminho de um socket Unix.
+ * @param endereco O endereço.
+ * @param escuta true para escutar (servidor), false para conectar (cliente).
+ * @return O descritor do socket, ou -1 em caso de erro.
+ */
+int abre_socket(const char *endereco, bool escuta)
+{
+    bool tcp = endereco[0] != '\0' && strspn(endereco, "0123456789") == strlen(endereco);
+    int fd = socket(tcp ? AF_INET : AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        std::cerr << "Erro ao criar o socket: " << strerror(errno) << "\n";
+        return -1;
+    }
+
+    sockaddr_in ip;
+    sockaddr_un local;
+    sockaddr *end;
+    socklen_t tam;
+    if (tcp) {
+        memset(&ip, 0, sizeof(ip));
+        ip.sin_family = AF_INET;
+        ip.sin_port = htons((uint16_t) atoi(endereco));
+        ip.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        end = (sockaddr *) &ip;
+        tam = sizeof(ip);
+
+        // Pedidos pequenos não devem esperar pelo algoritmo de Nagle
+        int um = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &um, sizeof(um));
+        if (escuta)
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &um, sizeof(um));
+    } else {
+        if (strlen(endereco) >= sizeof(local.sun_path)) {
+            std::cerr << "Caminho de socket muito longo: " << endereco << "\n";
+            close(fd);
+            return -1;
+        }
+        memset(&local, 0, sizeof(local));
+        local.sun_family = AF_UNIX;
+        strcpy(local.sun_path, endereco);
+        end = (sockaddr *) &local;
+        tam = sizeof(local);
+        if (escuta)
+            unlink(endereco);
+    }
+
+    int r = escuta ? bind(fd, end, tam) : connect(fd, end, tam);
+    if (r == 0 && escuta)
+        r = listen(fd, 128);
+    if (r != 0) {
+        std::cerr << "Erro ao abrir " << endereco << ": " << strerror(errno) << "\n";
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+#ifdef __linux__
+/**
+ * @class ServidorInventario
+ * @brief Servidor local do inventário, com um laço de eventos epoll numa única thread.
+ *
+ * @details Cada conexão acumula os bytes recebidos e atende, de uma vez, todos os pedidos completos que chegaram (pipelining); as respostas vão para um buffer de saída que é enviado com uma única chamada sempre que possível (respostas em lote). A árvore só é tocada por esta thread, então não precisa de travas.
+ * @details Quando o buffer de saída de uma conexão passa de LIMITE_SAIDA bytes (um cliente que envia pedidos sem ler as respostas), o servidor para de ler e de atender os pedidos dela até que o envio esvazie o buffer; os pedidos já recebidos esperam na entrada.
+ */
+class ServidorInventario
+{
+private:
+
+    struct Conexao
+    {
+        std::vector<char> entrada;
+        std::vector<char> saida;
+        size_t enviado;
+
+        Conexao() : enviado(0) {}
+    };
+
+    static const size_t LIMITE_SAIDA = 1 << 20;
+
+    AVL &T;
+    int escuta;
+    int epoll;
+    std::unordered_map<int, Conexao> conexoes;
+    long long pedidos;
+    bool compacta_ocioso; // Compacta a árvore quando não há pedidos
+    long long compactacoes;
+
+    /**
+     * @brief Acrescenta o cabeçalho de uma resposta ao buffer de saída.
+     */
+    static void responde(Conexao &c, uint8_t situacao, uint32_t quantidade) {
+        size_t n = c.saida.size();
+        c.saida.resize(n + TAM_RESPOSTA);
+        c.saida[n] = (char) situacao;
+        memcpy(&c.saida[n + 1], &quantidade, 4);
+    }
+
+    /**
+     * @brief Atende um pedido, escrevendo a resposta no buffer de saída.
+     * @param c A conexão.
+     * @param p Os bytes do pedido.
+     * @return false se a operação for desconhecida.
+     */
+    bool atende(Conexao &c, const char *p) {
+        int32_t codigo, max;
+        memcpy(&codigo, p + 1, 4);
+        memcpy(&max, p + 5, 4);
+
+        switch (p[0]) {
+            case OP_BUSCA:
+                responde(c, T.busca(codigo) != nullptr, 0);
+                break;
+            case OP_INSERE: {
+                bool novo = T.busca(codigo) == nullptr;
+                if (novo)
+                    T.insere(codigo);
+                responde(c, novo, 0);
+                break;
+            }
+            case OP_REMOVE:
+                responde(c, T.remove(codigo), 0);
+                break;
+            case OP_INTERVALO: {
+                size_t cabecalho = c.saida.size();
+                responde(c, 1, 0);
+                uint32_t quantidade = 0;
+                for (No *x = T.teto(codigo); x != nullptr && x->get_codigo() <= max; x = T.sucessor(x)) {
+                    int32_t k = x->get_codigo();
+                    size_t n = c.saida.size();
+                    c.saida.resize(n + 4);
+                    memcpy(&c.saida[n], &k, 4);
+                    quantidade++;
+                }
+                memcpy(&c.saida[cabecalho + 1], &quantidade, 4);
+                break;
+            }
+            case OP_CONTA:
+                responde(c, 1, codigo > max ? 0 : (uint32_t) T.agrega_intervalo(codigo, max).itens);
+                break;
+            default:
+                return false;
+        }
+        pedidos++;
+        return true;
+    }
+
+    /**
+     * @brief Verifica se o buffer de saída de uma conexão passou do limite.
+     */
+    static bool cheia(const Conexao &c) {
+        return c.saida.size() >= LIMITE_SAIDA;
+    }
+
+    /**
+     * @brief Atende os pedidos completos da entrada, até o buffer de saída passar do limite.
+     * @return false se um pedido tiver operação desconhecida.
+     */
+    bool atende_pendentes(Conexao &c) {
+        size_t pos = 0;
+        for (; c.entrada.size() - pos >= TAM_PEDIDO && !cheia(c); pos += TAM_PEDIDO)
+            if (!atende(c, &c.entrada[pos]))
+                return false;
+        c.entrada.erase(c.entrada.begin(), c.entrada.begin() + pos);
+        return true;
+    }
+
+    /**
+     * @brief Envia o que for possível do buffer de saída e ajusta o interesse em EPOLLIN e EPOLLOUT.
+     * @return false se a conexão falhou.
+     */
+    bool envia(int fd, Conexao &c) {
+        while (c.enviado < c.saida.size()) {
+            ssize_t n = send(fd, &c.saida[c.enviado], c.saida.size() - c.enviado, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    break;
+                return false;
+            }
+            c.enviado += n;
+        }
+
+        // Descarta o que já foi enviado, para que o buffer guarde só o que falta
+        c.saida.erase(c.saida.begin(), c.saida.begin() + c.enviado);
+        c.enviado = 0;
+
+        // Com o buffer cheio, a conexão só volta a ser lida depois que ele esvaziar
+        bool pendente = !c.saida.empty();
+        epoll_event ev;
+        ev.events = cheia(c) ? EPOLLOUT : (pendente ? (EPOLLIN | EPOLLOUT) : EPOLLIN);
+        ev.data.fd = fd;
+        epoll_ctl(epoll, EPOLL_CTL_MOD, fd, &ev);
+        return true;
+    }
+
+    /**
+     * @brief Lê tudo o que chegou em uma conexão e atende os pedidos completos, enquanto o buffer de saída não estiver cheio.
+     * @return false se a conexão foi fechada ou falhou.
+     */
+    bool recebe(int fd, Conexao &c) {
+        char buf[65536];
+        while (!cheia(c)) {
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n == 0)
+                return false;
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    break;
+                return false;
+            }
+            c.entrada.insert(c.entrada.end(), buf, buf + n);
+
+            // Atende os pedidos completos; o resto fica para a próxima leitura
+            if (!atende_pendentes(c))
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Fecha uma conexão.
+     */
+    void fecha(int fd) {
+        epoll_ctl(epoll, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        conexoes.erase(fd);
+    }
+
+    /**
+     * @brief Aceita todas as conexões pendentes.
+     */
+    void aceita() {
+        while (true) {
+            int fd = accept(escuta, nullptr, nullptr);
+            if (fd < 0)
+                return;
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+            int um = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &um, sizeof(um));
+
+            epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.fd = fd;
+            epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &ev);
+            conexoes[fd];
+        }
+    }
+
+public:
+
+    /**
+     * @brief Construtor do servidor.
+     * @param T A árvore servida.
+     */
+    ServidorInventario(AVL &T) : T(T), escuta(-1), epoll(-1), pedidos(0), compacta_ocioso(false), compactacoes(0) {}
+
+    /**
+     * @brief Destrutor: fecha todas as conexões.
+     */
+    ~ServidorInventario() {
+        for (std::unordered_map<int, Conexao>::iterator it = conexoes.begin(); it != conexoes.end(); ++it)
+            close(it->first);
+        if (escuta >= 0)
+            close(escuta);
+        if (epoll >= 0)
+            close(epoll);
+    }
+
+    ServidorInventario(const ServidorInventario &) = delete;
+    ServidorInventario &operator=(const ServidorInventario &) = delete;
+
+    /**
+     * @brief Começa a escutar em um endereço local.
+     * @param endereco Uma porta TCP (em 127.0.0.1) ou o caminho de um socket Unix.
+     * @return false em caso de erro.
+     */
+    bool abre(const char *endereco) {
+        escuta = abre_socket(endereco, true);
+        if (escuta < 0)
+            return false;
+        fcntl(escuta, F_SETFL, fcntl(escuta, F_GETFL, 0) | O_NONBLOCK);
+
+        epoll = epoll_create1(0);
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = escuta;
+        epoll_ctl(epoll, EPOLL_CTL_ADD, escuta, &ev);
+        return true;
+    }
+
+    /**
+     * @brief Atende as conexões até receber SIGINT ou SIGTERM.
+     */
+    void executa() {
+        epoll_event eventos[256];
+        while (servidor_ativo) {
+            int n = epoll_wait(epoll, eventos, 256, 500);
+
+            // Meio segundo sem pedidos: hora de devolver a localidade à árvore, se ela envelheceu
+            if (n == 0 && compacta_ocioso && T.precisa_compactar()) {
+                T.compacta();
+                compactacoes++;
+            }
+            for (int i = 0; i < n; i++) {
+                int fd = eventos[i].data.fd;
+                if (fd == escuta) {
+                    aceita();
+                    continue;
+                }
+
+                Conexao &c = conexoes[fd];
+                bool ok = !(eventos[i].events & (EPOLLERR | EPOLLHUP)) || (eventos[i].events & EPOLLIN);
+                if (ok && (eventos[i].events & EPOLLIN))
+                    ok = recebe(fd, c);
+
+                // Mesmo com um pedido inválido, as respostas anteriores a ele são enviadas
+                bool enviou = envia(fd, c);
+
+                // O envio abriu espaço: atende os pedidos que esperavam na entrada
+                while (ok && enviou && !cheia(c) && c.entrada.size() >= TAM_PEDIDO) {
+                    ok = atende_pendentes(c);
+                    enviou = envia(fd, c);
+                }
+                if (!ok || !enviou)
+                    fecha(fd);
+            }
+        }
+    }
+
+    /**
+     * @brief Retorna o número de pedidos atendidos.
+     */
+    long long get_pedidos() const {
+        return pedidos;
+    }
+
+    /**
+     * @brief Faz o servidor compactar a árvore nos intervalos sem pedidos, quando ela precisar.
+     */
+    void ativa_compactacao_ociosa() {
+        compacta_ocioso = true;
+    }
+
+    /**
+     * @brief Retorna o número de compactações feitas.
+     */
+    long long get_compactacoes() const {
+        return compactacoes;
+    }
+};
+#endif
+
+/**
+ * @brief Número máximo de corridas intercaladas de uma vez na ordenação externa.
+ */
+#define MAX_CORRIDAS 64
+
+/**
+ * @class LeitorCodigos
+ * @brief Leitor de códigos de um arquivo, texto (um por linha) ou binário (int em ordem de máquina), com buffer de tamanho fixo.
+ */
+class LeitorCodigos
+{
+private:
+
+    FILE *arquivo;
+    bool texto;
+    char buffer[1 << 16];
+    size_t pos, fim;
+
+    /**
+     * @brief Recarrega o buffer.
+     * @return false no fim do arquivo.
+     */
+    bool recarrega() {
+        // Bytes de um int binário cortado pelo fim do buffer vão para o início
+        size_t resto = fim - pos;
+        memmove(buffer, buffer + pos, resto);
+        pos = 0;
+        fim = resto + fread(buffer + resto, 1, sizeof(buffer) - resto, arquivo);
+        if (ferror(arquivo)) {
+            std::cerr << "Erro de leitura em arquivo de códigos" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        return fim > resto;
+    }
+
+public:
+
+    /**
+     * @brief Construtor do leitor.
+     * @param arquivo O arquivo, já aberto e posicionado no início.
+     * @param texto true para texto, false para binário.
+     */
+    LeitorCodigos(FILE *arquivo, bool texto) : arquivo(arquivo), texto(texto), pos(0), fim(0) {}
+
+    /**
+     * @brief Lê o próximo código.
+     * @param codigo Recebe o código.
+     * @return false no fim do arquivo.
+     */
+    bool proximo(int &codigo) {
+        if (!texto) {
+            if (fim - pos < sizeof(int) && (!recarrega() || fim - pos < sizeof(int)))
+                return false;
+            memcpy(&codigo, buffer + pos, sizeof(int));
+            pos += sizeof(int);
+            return true;
+        }
+
+        // Pula até o início de um número
+        while (true) {
+            if (pos == fim && !recarrega())
+                return false;
+            if (buffer[pos] == '-' || (buffer[pos] >= '0' && buffer[pos] <= '9'))
+                break;
+            pos++;
+        }
+
+        bool negativo = buffer[pos] == '-';
+        if (negativo)
+            pos++;
+        long valor = 0;
+        while ((pos < fim || recarrega()) && buffer[pos] >= '0' && buffer[pos] <= '9')
+            valor = valor * 10 + (buffer[pos++] - '0');
+        codigo = (int) (negativo ? -valor : valor);
+        return true;
+    }
+};
+
+/**
+ * @class EscritorCodigos
+ * @brief Escritor de códigos em um arquivo, texto (um por linha) ou binário, com buffer de tamanho fixo.
+ */
+class EscritorCodigos
+{
+private:
+
+    FILE *arquivo;
+    bool texto;
+    char buffer[1 << 16];
+    size_t fim;
+    long long escritos;
+
+public:
+
+    /**
+     * @brief Construtor do escritor.
+     * @param arquivo O arquivo, já aberto.
+     * @param texto true para texto, false para binário.
+     */
+    EscritorCodigos(FILE *arquivo, bool texto) : arquivo(arquivo), texto(texto), fim(0), escritos(0) {}
+
+    /**
+     * @brief Destrutor: descarrega o buffer.
+     */
+    ~EscritorCodigos() {
+        descarrega();
+    }
+
+    /**
+     * @brief Escreve um código.
+     * @param codigo O código.
+     */
+    void escreve(int codigo) {
+        if (sizeof(buffer) - fim < 16)
+            descarrega();
+        if (texto) {
+            fim += sprintf(buffer + fim, "%d\n", codigo);
+        } else {
+            memcpy(buffer + fim, &codigo, sizeof(int));
+            fim += sizeof(int);
+        }
+        escritos++;
+    }
+
+    /**
+     * @brief Grava no arquivo o conteúdo do buffer.
+     */
+    void descarrega() {
+        if (fim > 0 && fwrite(buffer, 1, fim, arquivo) != fim) {
+            std::cerr << "Erro de escrita em arquivo de códigos" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        fim = 0;
+    }
+
+    /**
+     * @brief Retorna o número de códigos escritos.
+     */
+    long long get_escritos() const {
+        return escritos;
+    }
+};
+
+
+/**
+ * @brief Conta o número de linhas em um arquivo de texto.
+ * 
+ * @param filename O nome do arquivo de texto.
+ * @return O número de linhas no arquivo.
+ */
+int contar_linhas(const char *filename)
+{
+    FILE *file = fopen(filename, "r");
+    if (file == NULL)
+    {
+        std::cerr << "Erro ao abrir o arquivo: " << filename << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    int linhas = 0;
+    char ch;
+    while ((ch = fgetc(file)) != EOF)
+    {
+        if (ch == '\n')
+        {
+            linhas++;
+        }
+    }
+
+    if (ferror(file))
+    {
+        std::cerr << "Erro de leitura no arquivo: " << filename << std::endl;
+        fclose(file);
+        exit(EXIT_FAILURE);
+    }
+
+    fclose(file);
+    return linhas;
+}
+
+/**
+ * @brief Lê um arquivo de texto e retorna um vetor de inteiros.
+ * 
+ * @param filename O nome do arquivo de texto.
+ * @return Um vetor de inteiros lidos do arquivo.
+ */
+void ler_arquivo(const char *filename, int valores[], int &tamanho)
+{
+    tamanho = contar_linhas(filename);
+    if (tamanho > MAX)
+    {
+        std::cerr << "O arquivo contém mais elementos do que o tamanho máximo permitido ("
+                  << MAX << "). Redefina o limite.\n";
+        exit(EXIT_FAILURE);
+    }
+
+    FILE *file = fopen(filename, "r");
+    if (file == NULL)
+    {
+        std::cerr << "Erro ao abrir o arquivo: " << filename << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    // Lê os valores do arquivo
+
+    
+    int i = 0;
+    while (fscanf(file, "%d", &valores[i]) != EOF && i < tamanho)
+    {
+        i++;
+    }
+
+    if (ferror(file))
+    {
+        std::cerr << "Erro de leitura no arquivo: " << filename << std::endl;
+        fclose(file);
+        exit(EXIT_FAILURE);
+    }
+
+    fclose(file);
+}
+
+/**
+ * @brief Ordena blocos já ordenados intercalando-os dois a dois, em paralelo.
+ * 
+ * @param blocos Blocos ordenados; ao final, blocos[0] contém todos os códigos em ordem.
+ */
+void intercala_blocos(std::vector<std::vector<int> > &blocos)
+{
+    while (blocos.size() > 1)
+    {
+        size_t pares = blocos.size() / 2;
+        std::vector<std::vector<int> > proximos(pares + blocos.size() % 2);
+        std::vector<std::thread> threads;
+
+        for (size_t i = 0; i < pares; i++)
+            threads.emplace_back([&, i]() {
+                std::vector<int> &a = blocos[2 * i], &b = blocos[2 * i + 1];
+                proximos[i].resize(a.size() + b.size());
+                std::merge(a.begin(), a.end(), b.begin(), b.end(), proximos[i].begin());
+                std::vector<int>().swap(a);
+                std::vector<int>().swap(b);
+            });
+        for (std::thread &t : threads)
+            t.join();
+
+        if (blocos.size() % 2)
+            proximos.back().swap(blocos.back());
+        blocos.swap(proximos);
+    }
+}
+
+/**
+ * @brief Lê um arquivo de texto sem limite de tamanho, em paralelo, e retorna seus códigos ordenados e sem repetições.
+ * 
+ * @details O arquivo é lido inteiro para a memória e dividido em blocos nas quebras de linha. Cada thread converte e ordena o seu bloco; os blocos são então intercalados em paralelo.
+ * @param filename O nome do arquivo de texto.
+ * @param threads O número de threads a serem usadas.
+ * @return Um vetor ordenado com os códigos distintos do arquivo.
+ */
+std::vector<int> ler_arquivo_paralelo(const char *filename, int threads)
+{
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL)
+    {
+        std::cerr << "Erro ao abrir o arquivo: " << filename << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::vector<char> texto;
+    char buffer[1 << 16];
+    size_t lidos;
+    while ((lidos = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        texto.insert(texto.end(), buffer, buffer + lidos);
+
+    if (ferror(file))
+    {
+        std::cerr << "Erro de leitura no arquivo: " << filename << std::endl;
+        fclose(file);
+        exit(EXIT_FAILURE);
+    }
+    fclose(file);
+    texto.push_back('\0');
+
+    if (threads < 1)
+        threads = 1;
+
+    // Limites dos blocos, ajustados para começar após uma quebra de linha
+    std::vector<size_t> limites(threads + 1, texto.size() - 1);
+    limites[0] = 0;
+    for (int i = 1; i < threads; i++)
+    {
+        size_t pos = std::max(limites[i - 1], (texto.size() - 1) * i / threads);
+        while (pos < texto.size() - 1 && texto[pos] != '\n')
+            pos++;
+        limites[i] = pos;
+    }
+
+    std::vector<std::vector<int> > blocos(threads);
+    std::vector<std::thread> trabalhadores;
+    for (int i = 0; i < threads; i++)
+        trabalhadores.emplace_back([&, i]() {
+            const char *p = texto.data() + limites[i];
+            const char *fim = texto.data() + limites[i + 1];
+            char *prox;
+            while (p < fim)
+            {
+                long valor = strtol(p, &prox, 10);
+                if (prox == p)
+                {
+                    p++;
+                    continue;
+                }
+                blocos[i].push_back((int) valor);
+                p = prox;
+            }
+            std::sort(blocos[i].begin(), blocos[i].end());
+            blocos[i].erase(std::unique(blocos[i].begin(), blocos[i].end()), blocos[i].end());
+        });
+    for (std::thread &t : trabalhadores)
+        t.join();
+
+    intercala_blocos(blocos);
+    std::vector<int> &v = blocos[0];
+    v.erase(std::unique(v.begin(), v.end()), v.end());
+    return std::move(v);
+}
+
+/**
+ * @brief Carrega um arquivo de texto em uma árvore AVL usando o caminho paralelo.
+ * 
+ * @param filename O nome do arquivo de texto.
+ * @param T A árvore de destino.
+ * @param threads O número de threads a serem usadas.
+ * @return O tempo gasto, em segundos.
+ */
+double carrega_paralelo(const char *filename, AVL &T, int threads)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<int> v = ler_arquivo_paralelo(filename, threads);
+    T.carrega_ordenado(v, threads);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end - start;
+    return elapsed.count();
+}
+
+/**
+ * @brief Lê um arquivo de texto sem limite de tamanho, inserindo os códigos em um índice em disco.
+ * 
+ * @param filename O nome do arquivo de texto.
+ * @param indice O índice de destino.
+ * @return O número de códigos lidos do arquivo.
+ */
+long long ler_arquivo_paginado(const char *filename, ArvorePaginada &indice)
+{
+    FILE *file = fopen(filename, "r");
+    if (file == NULL)
+    {
+        std::cerr << "Erro ao abrir o arquivo: " << filename << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    long long lidos = 0;
+    int valor;
+    while (fscanf(file, "%d", &valor) == 1)
+    {
+        indice.insere(valor);
+        lidos++;
+    }
+
+    if (ferror(file))
+    {
+        std::cerr << "Erro de leitura no arquivo: " << filename << std::endl;
+        fclose(file);
+        exit(EXIT_FAILURE);
+    }
+
+    fclose(file);
+    return lidos;
+}
+
+/**
+ * @brief Intercala corridas binárias ordenadas e sem repetições em uma só, descartando repetições entre elas.
+ * 
+ * @details Usa um heap de mínimo com o próximo código de cada corrida; as corridas de entrada são fechadas.
+ * @param corridas As corridas, posicionadas no início (no máximo MAX_CORRIDAS).
+ * @return Um arquivo temporário com a corrida resultante, posicionado no início.
+ */
+FILE *intercala_corridas(const std::vector<FILE *> &corridas)
+{
+    FILE *saida = tmpfile();
+    if (saida == NULL)
+    {
+        std::cerr << "Erro ao criar arquivo temporário" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::vector<LeitorCodigos *> leitores;
+    typedef std::pair<int, size_t> Cabeca; // Código e índice da corrida
+    std::priority_queue<Cabeca, std::vector<Cabeca>, std::greater<Cabeca> > heap;
+    for (size_t i = 0; i < corridas.size(); i++)
+    {
+        leitores.push_back(new LeitorCodigos(corridas[i], false));
+        int codigo;
+        if (leitores[i]->proximo(codigo))
+            heap.push(Cabeca(codigo, i));
+    }
+
+    {
+        EscritorCodigos escritor(saida, false);
+        bool primeiro = true;
+        int ultimo = 0;
+        while (!heap.empty())
+        {
+            Cabeca c = heap.top();
+            heap.pop();
+            if (primeiro || c.first != ultimo)
+                escritor.escreve(c.first);
+            primeiro = false;
+            ultimo = c.first;
+
+            int codigo;
+            if (leitores[c.second]->proximo(codigo))
+                heap.push(Cabeca(codigo, c.second));
+        }
+    }
+
+    for (size_t i = 0; i < corridas.size(); i++)
+    {
+        delete leitores[i];
+        fclose(corridas[i]);
+    }
+    rewind(saida);
+    return saida;
+}
+
+/**
+ * @brief Ordena um arquivo de texto de códigos, de qualquer tamanho, com memória limitada.
+ * 
+ * @details Gera corridas ordenadas e sem repetições com até `memoria_codigos` códigos cada, gravadas em binário em arquivos temporários; sempre que MAX_CORRIDAS corridas se acumulam, elas são intercaladas numa só, de modo que nunca há mais que MAX_CORRIDAS + 1 arquivos temporários abertos. A memória usada não depende do tamanho do arquivo.
+ * @param filename O nome do arquivo de texto.
+ * @param memoria_codigos Quantos códigos cabem na memória de uma corrida.
+ * @param lidos Recebe o número de códigos lidos.
+ * @param num_corridas Recebe o número de corridas geradas.
+ * @return Um arquivo temporário binário com os códigos ordenados e sem repetições, posicionado no início.
+ */
+FILE *ordena_externo(const char *filename, size_t memoria_codigos, long long &lidos, int &num_corridas)
+{
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL)
+    {
+        std::cerr << "Erro ao abrir o arquivo: " << filename << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    // Geração das corridas
+    std::vector<FILE *> corridas;
+    lidos = 0;
+    num_corridas = 0;
+    {
+        LeitorCodigos leitor(file, true);
+        std::vector<int> bloco;
+        bloco.reserve(memoria_codigos);
+        bool fim = false;
+        while (!fim)
+        {
+            int codigo;
+            bloco.clear();
+            while (bloco.size() < memoria_codigos && !(fim = !leitor.proximo(codigo)))
+                bloco.push_back(codigo);
+            if (bloco.empty())
+                break;
+            lidos += bloco.size();
+
+            std::sort(bloco.begin(), bloco.end());
+            bloco.erase(std::unique(bloco.begin(), bloco.end()), bloco.end());
+
+            FILE *corrida = tmpfile();
+            if (corrida == NULL || fwrite(bloco.data(), sizeof(int), bloco.size(), corrida) != bloco.size())
+            {
+                std::cerr << "Erro ao gravar arquivo temporário" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            rewind(corrida);
+            corridas.push_back(corrida);
+            num_corridas++;
+
+            // Limita os arquivos abertos também durante a geração
+            if (corridas.size() == MAX_CORRIDAS)
+            {
+                FILE *intercalada = intercala_corridas(corridas);
+                corridas.assign(1, intercalada);
+            }
+        }
+    }
+    fclose(file);
+
+    // Restam no máximo MAX_CORRIDAS - 1 corridas: uma única passada
+    if (corridas.size() == 1)
+        return corridas[0];
+    return intercala_corridas(corridas);
+}
+
+/**
+ * @brief Combina duas sequências ordenadas e sem repetições, gravando o resultado como texto.
+ * 
+ * @param a A primeira sequência (binária).
+ * @param b A segunda sequência (binária).
+ * @param saida O arquivo de saída.
+ * @param operacao 'u' (união), 'i' (interseção) ou 'd' (diferença a - b).
+ * @return O número de códigos gravados.
+ */
+long long opera_externo(FILE *a, FILE *b, FILE *saida, char operacao)
+{
+    LeitorCodigos la(a, false), lb(b, false);
+    EscritorCodigos escritor(saida, true);
+    int x, y;
+    bool tem_a = la.proximo(x), tem_b = lb.proximo(y);
+
+    while (tem_a && tem_b)
+    {
+        if (x < y)
+        {
+            if (operacao != 'i')
+                escritor.escreve(x);
+            tem_a = la.proximo(x);
+        }
+        else if (y < x)
+        {
+            if (operacao == 'u')
+                escritor.escreve(y);
+            tem_b = lb.proximo(y);
+        }
+        else
+        {
+            if (operacao != 'd')
+                escritor.escreve(x);
+            tem_a = la.proximo(x);
+            tem_b = lb.proximo(y);
+        }
+    }
+
+    // O que sobrou de um dos lados
+    for (; tem_a && operacao != 'i'; tem_a = la.proximo(x))
+        escritor.escreve(x);
+    for (; tem_b && operacao == 'u'; tem_b = lb.proximo(y))
+        escritor.escreve(y);
+
+    escritor.descarrega();
+    return escritor.get_escritos();
+}
+
+/**
+ * @brief Modo de linha de comando para o índice em disco.
+ * 
+ * @details Uso: `programa.out --paginada <indice> <arquivo> [paginas_cache]`. Carrega o arquivo de códigos no índice (criando-o se não existir) e escreve as estatísticas do cache.
+ * @return O código de saída do programa.
+ */
+int modo_paginado(int argc, char *argv[])
+{
+    if (argc < 4)
+    {
+        std::cerr << "Uso: " << argv[0] << " --paginada <indice> <arquivo> [paginas_cache]\n";
+        return EXIT_FAILURE;
+    }
+
+    size_t paginas = argc > 4 ? strtoul(argv[4], NULL, 10) : 1024;
+    ArvorePaginada indice(argv[2], paginas);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    long long lidos = ler_arquivo_paginado(argv[3], indice);
+    indice.descarrega();
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end - start;
+
+    int min, max;
+    std::cout << "Códigos lidos: " << lidos << "\n";
+    if (indice.minimo(min) && indice.maximo(max))
+        std::cout << "Menor código: " << min << "\nMaior código: " << max << "\n";
+    indice.escreve_estatisticas();
+    std::cout << std::fixed << std::setprecision(6) << "Tempo de carga: " << elapsed.count() << " segundos\n";
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Semente dos sorteios dos modos de medição, fixa para que as medições sejam reproduzíveis.
+ */
+#define SEMENTE_SORTEIO 0x9e3779b97f4a7c15ULL
+
+/**
+ * @brief Sorteia um número pseudoaleatório (xorshift de 64 bits).
+ * 
+ * @param estado O estado do gerador, iniciado com SEMENTE_SORTEIO; é avançado a cada sorteio.
+ * @return O número sorteado.
+ */
+static inline uint64_t sorteia(uint64_t &estado)
+{
+    estado ^= estado << 13;
+    estado ^= estado >> 7;
+    estado ^= estado << 17;
+    return estado;
+}
+
+/**
+ * @brief Mede inserções, buscas e remoções em massa numa árvore com a política de balanceamento dada.
+ * 
+ * @param nome O nome da política.
+ * @param codigos Os códigos, em ordem aleatória.
+ */
+template <typename Politica>
+void mede_balanceamento(const char *nome, const std::vector<int> &codigos)
+{
+    ArvoreBalanceada<Politica> T;
+    std::chrono::duration<double> t_ins, t_busca, t_rem;
+
+    auto inicio = std::chrono::high_resolution_clock::now();
+    for (int codigo : codigos)
+        T.insere(codigo);
+    auto fim = std::chrono::high_resolution_clock::now();
+    t_ins = fim - inicio;
+    long long rot_ins = T.get_rotacoes();
+
+    inicio = std::chrono::high_resolution_clock::now();
+    size_t achados = 0;
+    for (int codigo : codigos)
+        achados += T.busca(codigo) != nullptr;
+    fim = std::chrono::high_resolution_clock::now();
+    t_busca = fim - inicio;
+
+    // Remove metade dos códigos, na ordem em que foram inseridos
+    inicio = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < codigos.size(); i += 2)
+        T.remove(codigos[i]);
+    fim = std::chrono::high_resolution_clock::now();
+    t_rem = fim - inicio;
+    long long rot_rem = T.get_rotacoes() - rot_ins;
+
+    double n = (double) codigos.size();
+    std::cout << nome << ":\n" << std::fixed << std::setprecision(6)
+              << "  Inserção: " << t_ins.count() << " s (" << std::setprecision(3) << rot_ins / n << " rotações/op)\n"
+              << std::setprecision(6)
+              << "  Busca:    " << t_busca.count() << " s (" << achados << " achados)\n"
+              << "  Remoção:  " << t_rem.count() << " s (" << std::setprecision(3) << rot_rem / (n / 2) << " rotações/op)\n";
+}
+
+/**
+ * @brief Modo de linha de comando que compara as políticas de balanceamento AVL e WAVL.
+ * 
+ * @details Uso: `programa.out --bench-balanceamento [n]`. Insere n códigos distintos em ordem aleatória, busca todos e remove metade, escrevendo os tempos e as rotações por operação de cada política.
+ * @return O código de saída do programa.
+ */
+int modo_bench_balanceamento(int argc, char *argv[])
+{
+    int n = argc > 2 ? atoi(argv[2]) : 1000000;
+    if (n <= 0) {
+        std::cerr << "Quantidade inválida: " << argv[2] << "\n";
+        return EXIT_FAILURE;
+    }
+
+    std::vector<int> codigos(n);
+    for (int i = 0; i < n; i++)
+        codigos[i] = i;
+    // Embaralha com um gerador fixo para que as duas políticas vejam a mesma sequência
+    uint64_t estado = SEMENTE_SORTEIO;
+    for (int i = n - 1; i > 0; i--)
+        std::swap(codigos[i], codigos[sorteia(estado) % (uint64_t) (i + 1)]);
+
+    mede_balanceamento<BalanceamentoAVL>("AVL", codigos);
+    mede_balanceamento<BalanceamentoWAVL>("WAVL", codigos);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Modo de linha de comando que mede o inventário fragmentado contra uma única árvore.
+ * 
+ * @details Uso: `programa.out --fragmentado [n] [fragmentos]`. Insere n códigos aleatórios com uma thread produtora por fragmento, compara o tempo com o de uma única árvore alimentada por uma thread e confere uma contagem por intervalo.
+ * @return O código de saída do programa.
+ */
+int modo_fragmentado(int argc, char *argv[])
+{
+    int n = argc > 2 ? atoi(argv[2]) : 1000000;
+    int num_fragmentos = argc > 3 ? atoi(argv[3]) : (int) std::thread::hardware_concurrency();
+    if (n <= 0 || num_fragmentos <= 0) {
+        std::cerr << "Uso: programa.out --fragmentado [n] [fragmentos]\n";
+        return EXIT_FAILURE;
+    }
+
+    int max_codigo = n > INT_MAX / 4 ? INT_MAX : n * 4;
+    std::vector<int> codigos(n);
+    uint64_t estado = SEMENTE_SORTEIO;
+    for (int i = 0; i < n; i++)
+        codigos[i] = (int) (sorteia(estado) % (uint64_t) max_codigo);
+
+    // Uma única árvore, alimentada por uma thread
+    AVL T;
+    auto inicio = std::chrono::high_resolution_clock::now();
+    for (int codigo : codigos)
+        if (T.busca(codigo) == nullptr)
+            T.insere(codigo);
+    auto fim = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> t_unica = fim - inicio;
+
+    // Inventário fragmentado, alimentado por uma thread produtora por fragmento
+    InventarioFragmentado inventario(num_fragmentos, 0, max_codigo - 1);
+    inicio = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> produtores;
+    for (int p = 0; p < num_fragmentos; p++) {
+        produtores.push_back(std::thread([&, p]() {
+            for (int i = p; i < n; i += num_fragmentos)
+                inventario.insere(codigos[i]);
+        }));
+    }
+    for (size_t p = 0; p < produtores.size(); p++)
+        produtores[p].join();
+    inventario.sincroniza();
+    fim = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> t_fragmentado = fim - inicio;
+
+    int min = max_codigo / 3, max = max_codigo / 3 + max_codigo / 10;
+    long long esperado = T.agrega_intervalo(min, max).itens;
+    long long obtido = inventario.conta_intervalo(min, max);
+
+    std::cout << std::fixed << std::setprecision(6)
+              << "Árvore única: " << t_unica.count() << " s\n"
+              << num_fragmentos << " fragmentos: " << t_fragmentado.count() << " s ("
+              << std::setprecision(2) << t_unica.count() / t_fragmentado.count() << "x)\n"
+              << "Códigos distintos: " << inventario.tamanho() << "\n"
+              << "Intervalo [" << min << ", " << max << "]: " << obtido << " códigos"
+              << (obtido == esperado ? "" : " (DIVERGENTE)") << "\n";
+    return obtido == esperado ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#ifdef __linux__
+/**
+ * @brief Modo de linha de comando que serve o inventário por um socket local.
+ * 
+ * @details Uso: `programa.out --servidor <endereco> [arquivo] [--compacta-ocioso]`. Carrega o arquivo de códigos, se dado, e atende pedidos no protocolo binário até receber SIGINT ou SIGTERM. Com `--compacta-ocioso`, a árvore é compactada nos intervalos sem pedidos, quando já sofreu alterações suficientes.
+ * @return O código de saída do programa.
+ */
+int modo_servidor(int argc, char *argv[])
+{
+    if (argc < 3) {
+        std::cerr << "Uso: programa.out --servidor <porta|caminho> [arquivo] [--compacta-ocioso]\n";
+        return EXIT_FAILURE;
+    }
+
+    const char *arquivo = nullptr;
+    bool compacta_ocioso = false;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--compacta-ocioso") == 0)
+            compacta_ocioso = true;
+        else
+            arquivo = argv[i];
+    }
+
+    AVL T;
+    T.ativa_indice_hash();
+    if (arquivo != nullptr) {
+        unsigned int threads = std::thread::hardware_concurrency();
+        double segundos = carrega_paralelo(arquivo, T, threads ? threads : 1);
+        std::cout << std::fixed << std::setprecision(6) << "Carga: " << segundos << " segundos\n";
+    }
+
+    ServidorInventario servidor(T);
+    if (!servidor.abre(argv[2]))
+        return EXIT_FAILURE;
+    if (compacta_ocioso)
+        servidor.ativa_compactacao_ociosa();
+    signal(SIGINT, para_servidor);
+    signal(SIGTERM, para_servidor);
+
+    std::cout << "Servindo em " << argv[2] << std::endl;
+    servidor.executa();
+    std::cout << "Pedidos atendidos: " << servidor.get_pedidos() << "\n"
+              << "Compactações: " << servidor.get_compactacoes() << "\n";
+
+    bool tcp = strspn(argv[2], "0123456789") == strlen(argv[2]);
+    if (!tcp)
+        unlink(argv[2]);
+    return EXIT_SUCCESS;
+}
+#endif
+
+/**
+ * @brief Modo de linha de comando que gera carga contra o servidor e mede vazão e latência.
+ * 
+ * @details Uso: `programa.out --cliente <endereco> [pedidos] [profundidade] [max_codigo]`. Mantém até `profundidade` pedidos em trânsito (90% buscas, 5% inserções e 5% remoções de códigos aleatórios em [0, max_codigo)) e, ao final, escreve a vazão e os percentis de latência.
+ * @return O código de saída do programa.
+ */
+int modo_cliente(int argc, char *argv[])
+{
+    if (argc < 3) {
+        std::cerr << "Uso: programa.out --cliente <porta|caminho> [pedidos] [profundidade] [max_codigo]\n";
+        return EXIT_FAILURE;
+    }
+    long long total = argc > 3 ? atoll(argv[3]) : 1000000;
+    int profundidade = argc > 4 ? atoi(argv[4]) : 64;
+    int max_codigo = argc > 5 ? atoi(argv[5]) : 1000000;
+    if (total <= 0 || profundidade <= 0 || max_codigo <= 0) {
+        std::cerr << "Parâmetros inválidos\n";
+        return EXIT_FAILURE;
+    }
+
+    int fd = abre_socket(argv[2], false);
+    if (fd < 0)
+        return EXIT_FAILURE;
+
+    typedef std::chrono::high_resolution_clock relogio;
+    std::list<relogio::time_point> em_transito; // Respostas chegam na ordem dos pedidos
+    std::vector<double> latencias;
+    latencias.reserve(total);
+    std::vector<char> saida, entrada;
+    long long emitidos = 0, achados = 0;
+    uint64_t estado = SEMENTE_SORTEIO;
+
+    // Acrescenta um pedido aleatório ao buffer de saída
+    auto gera = [&]() {
+        sorteia(estado);
+        int sorteio = (int) (estado % 100);
+        char op = sorteio < 90 ? OP_BUSCA : (sorteio < 95 ? OP_INSERE : OP_REMOVE);
+        int32_t codigo = (int32_t) ((estado >> 8) % (uint64_t) max_codigo), max = 0;
+
+        size_t n = saida.size();
+        saida.resize(n + TAM_PEDIDO);
+        saida[n] = op;
+        memcpy(&saida[n + 1], &codigo, 4);
+        memcpy(&saida[n + 5], &max, 4);
+        em_transito.push_back(relogio::now());
+        emitidos++;
+    };
+
+    // Envia todo o buffer de saída
+    auto descarrega = [&]() -> bool {
+        size_t enviado = 0;
+        while (enviado < saida.size()) {
+            ssize_t n = send(fd, &saida[enviado], saida.size() - enviado, MSG_NOSIGNAL);
+            if (n < 0 && errno != EINTR)
+                return false;
+            if (n > 0)
+                enviado += n;
+        }
+        saida.clear();
+        return true;
+    };
+
+    auto inicio = relogio::now();
+    while (emitidos < total && emitidos < profundidade)
+        gera();
+    bool ok = descarrega();
+
+    char buf[65536];
+    while (ok && (long long) latencias.size() < total) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR)
+                continue;
+            ok = false;
+            break;
+        }
+        entrada.insert(entrada.end(), buf, buf + n);
+
+        // Cada resposta completa libera um novo pedido
+        size_t pos = 0;
+        relogio::time_point agora = relogio::now();
+        while (entrada.size() - pos >= TAM_RESPOSTA) {
+            achados += entrada[pos] != 0;
+            pos += TAM_RESPOSTA;
+            latencias.push_back(std::chrono::duration<double, std::micro>(agora - em_transito.front()).count());
+            em_transito.pop_front();
+            if (emitidos < total)
+                gera();
+        }
+        entrada.erase(entrada.begin(), entrada.begin() + pos);
+        ok = descarrega();
+    }
+    auto fim = relogio::now();
+    close(fd);
+
+    if (!ok) {
+        std::cerr << "Conexão encerrada pelo servidor após " << latencias.size() << " respostas\n";
+        return EXIT_FAILURE;
+    }
+
+    std::chrono::duration<double> elapsed = fim - inicio;
+    std::sort(latencias.begin(), latencias.end());
+    std::cout << std::fixed << std::setprecision(0)
+              << "Pedidos: " << total << " (" << achados << " com sucesso)\n"
+              << "Vazão: " << total / elapsed.count() << " pedidos/s\n"
+              << std::setprecision(1)
+              << "Latência (us): p50 " << latencias[latencias.size() / 2]
+              << ", p99 " << latencias[latencias.size() * 99 / 100]
+              << ", máx " << latencias.back() << "\n";
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Modo de linha de comando para união, interseção e diferença de arquivos maiores que a memória.
+ * 
+ * @details Uso: `programa.out --externo <uniao|intersecao|diferenca> <A> <B> <saida> [memoria_mb]`. Ordena cada arquivo externamente, sem montar árvores, e grava em `saida` o resultado ordenado, um código por linha.
+ * @return O código de saída do programa.
+ */
+int modo_externo(int argc, char *argv[])
+{
+    if (argc < 6)
+    {
+        std::cerr << "Uso: programa.out --externo <uniao|intersecao|diferenca> <A> <B> <saida> [memoria_mb]\n";
+        return EXIT_FAILURE;
+    }
+
+    char operacao;
+    if (strcmp(argv[2], "uniao") == 0)
+        operacao = 'u';
+    else if (strcmp(argv[2], "intersecao") == 0)
+        operacao = 'i';
+    else if (strcmp(argv[2], "diferenca") == 0)
+        operacao = 'd';
+    else
+    {
+        std::cerr << "Operação desconhecida: " << argv[2] << "\n";
+        return EXIT_FAILURE;
+    }
+
+    long memoria_mb = argc > 6 ? atol(argv[6]) : 64;
+    if (memoria_mb <= 0)
+    {
+        std::cerr << "Memória inválida: " << argv[6] << "\n";
+        return EXIT_FAILURE;
+    }
+    size_t memoria_codigos = (size_t) memoria_mb * 1024 * 1024 / sizeof(int);
+
+    auto inicio = std::chrono::high_resolution_clock::now();
+    long long lidos_a, lidos_b;
+    int corridas_a, corridas_b;
+    FILE *a = ordena_externo(argv[3], memoria_codigos, lidos_a, corridas_a);
+    FILE *b = ordena_externo(argv[4], memoria_codigos, lidos_b, corridas_b);
+
+    FILE *saida = fopen(argv[5], "w");
+    if (saida == NULL)
+    {
+        std::cerr << "Erro ao criar o arquivo: " << argv[5] << std::endl;
+        return EXIT_FAILURE;
+    }
+    long long gravados = opera_externo(a, b, saida, operacao);
+    fclose(a);
+    fclose(b);
+    if (fclose(saida) != 0)
+    {
+        std::cerr << "Erro ao gravar o arquivo: " << argv[5] << std::endl;
+        return EXIT_FAILURE;
+    }
+    auto fim = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double> elapsed = fim - inicio;
+    std::cout << argv[3] << ": " << lidos_a << " códigos em " << corridas_a << " corridas\n"
+              << argv[4] << ": " << lidos_b << " códigos em " << corridas_b << " corridas\n"
+              << "Resultado: " << gravados << " códigos em " << argv[5] << "\n"
+              << std::fixed << std::setprecision(6) << "Tempo: " << elapsed.count() << " segundos\n";
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Modo de linha de comando que une ou intersecciona vários inventários de uma vez.
+ * 
+ * @details Uso: `programa.out --multiplos <uniao|intersecao> <arquivo1> <arquivo2> ...`. Carrega cada arquivo em uma árvore e compara a operação em uma passada com o encadeamento de operações entre pares.
+ * @return O código de saída do programa.
+ */
+int modo_multiplos(int argc, char *argv[])
+{
+    if (argc < 4 || (strcmp(argv[2], "uniao") != 0 && strcmp(argv[2], "intersecao") != 0))
+    {
+        std::cerr << "Uso: programa.out --multiplos <uniao|intersecao> <arquivo1> <arquivo2> ...\n";
+        return EXIT_FAILURE;
+    }
+    bool uniao = strcmp(argv[2], "uniao") == 0;
+
+    unsigned int threads = std::thread::hardware_concurrency();
+    std::vector<AVL *> arvores;
+    for (int i = 3; i < argc; i++)
+    {
+        arvores.push_back(new AVL());
+        carrega_paralelo(argv[i], *arvores.back(), threads ? threads : 1);
+    }
+
+    // Todas as árvores numa única passada
+    AVL resultado;
+    auto inicio = std::chrono::high_resolution_clock::now();
+    if (uniao)
+        AVL::uniao(arvores, resultado);
+    else
+        AVL::intersecao(arvores, resultado);
+    auto fim = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> t_multiplo = fim - inicio;
+
+    // Encadeando pares: cada passo recopia o resultado anterior
+    AVL acumulado(*arvores[0]);
+    inicio = std::chrono::high_resolution_clock::now();
+    for (size_t i = 1; i < arvores.size(); i++)
+    {
+        std::vector<AVL *> par;
+        par.push_back(&acumulado);
+        par.push_back(arvores[i]);
+        if (uniao)
+            AVL::uniao(par, acumulado);
+        else
+            AVL::intersecao(par, acumulado);
+    }
+    fim = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> t_pares = fim - inicio;
+
+    std::vector<int> codigos;
+    resultado.em_ordem(codigos);
+    std::cout << (uniao ? "União" : "Interseção") << " de " << arvores.size() << " inventários: " << codigos.size() << " códigos\n"
+              << std::fixed << std::setprecision(6)
+              << "Uma passada: " << t_multiplo.count() << " segundos\n"
+              << "Pares encadeados: " << t_pares.count() << " segundos\n";
+
+    for (size_t i = 0; i < arvores.size(); i++)
+        delete arvores[i];
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Modo de linha de comando que compara o inventário compactado com a árvore.
+ * 
+ * @details Uso: `programa.out --compactado <arquivo> [arquivo2]`. Compacta o inventário do arquivo e compara memória e tempo de busca com a árvore; com um segundo arquivo, compara também a interseção.
+ * @return O código de saída do programa.
+ */
+int modo_compactado(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        std::cerr << "Uso: programa.out --compactado <arquivo> [arquivo2]\n";
+        return EXIT_FAILURE;
+    }
+
+    unsigned int threads = std::thread::hardware_concurrency();
+    AVL T1;
+    carrega_paralelo(argv[2], T1, threads ? threads : 1);
+    InventarioCompactado C1(T1);
+
+    std::cout << "Códigos: " << C1.tamanho() << "\n"
+              << "Memória da árvore: " << T1.memoria_nos() << " bytes\n"
+              << "Memória compactada: " << C1.memoria() << " bytes";
+    if (C1.memoria() > 0)
+        std::cout << std::fixed << std::setprecision(1) << " (" << (double) T1.memoria_nos() / C1.memoria() << "x menor)";
+    std::cout << "\n";
+
+    // Buscas por códigos aleatórios entre o menor e o maior
+    if (C1.tamanho() > 0)
+    {
+        long long min = T1.minimo()->get_codigo(), max = T1.maximo()->get_codigo();
+        std::vector<int> consultas(1000000);
+        uint64_t estado = SEMENTE_SORTEIO;
+        for (size_t i = 0; i < consultas.size(); i++)
+            consultas[i] = (int) (min + (long long) (sorteia(estado) % (uint64_t) (max - min + 1)));
+
+        long long achados_arvore = 0, achados_compactado = 0;
+        auto inicio = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < consultas.size(); i++)
+            achados_arvore += T1.busca(consultas[i]) != nullptr;
+        auto meio = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < consultas.size(); i++)
+            achados_compactado += C1.busca(consultas[i]);
+        auto fim = std::chrono::high_resolution_clock::now();
+
+        std::chrono::duration<double> t_arvore = meio - inicio, t_compactado = fim - meio;
+        std::cout << std::fixed << std::setprecision(6)
+                  << consultas.size() << " buscas na árvore: " << t_arvore.count() << " s (" << achados_arvore << " achados)\n"
+                  << consultas.size() << " buscas compactadas: " << t_compactado.count() << " s (" << achados_compactado << " achados)\n";
+    }
+
+    if (argc > 3)
+    {
+        AVL T2, resultado;
+        carrega_paralelo(argv[3], T2, threads ? threads : 1);
+        InventarioCompactado C2(T2);
+
+        std::vector<AVL *> arvores;
+        arvores.push_back(&T1);
+        arvores.push_back(&T2);
+        auto inicio = std::chrono::high_resolution_clock::now();
+        AVL::intersecao(arvores, resultado);
+        auto meio = std::chrono::high_resolution_clock::now();
+        std::vector<int> comuns = InventarioCompactado::intersecao(C1, C2);
+        auto fim = std::chrono::high_resolution_clock::now();
+
+        std::chrono::duration<double> t_arvore = meio - inicio, t_compactado = fim - meio;
+        std::cout << std::fixed << std::setprecision(6)
+                  << "Interseção das árvores: " << t_arvore.count() << " s\n"
+                  << "Interseção compactada: " << t_compactado.count() << " s (" << comuns.size() << " códigos)\n";
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Mede buscas aleatórias e um percurso completo por sucessores.
+ * 
+ * @param rotulo O rótulo da medição.
+ * @param T A árvore.
+ * @param consultas Os códigos buscados.
+ */
+void mede_localidade(const char *rotulo, AVL &T, const std::vector<int> &consultas)
+{
+    long long achados = 0, percorridos = 0;
+    auto inicio = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < consultas.size(); i++)
+        achados += T.busca(consultas[i]) != nullptr;
+    auto meio = std::chrono::high_resolution_clock::now();
+    for (No *x = T.minimo(); x != nullptr; x = T.sucessor(x))
+        percorridos++;
+    auto fim = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double> t_busca = meio - inicio, t_percurso = fim - meio;
+    std::cout << rotulo << ":\n" << std::fixed << std::setprecision(6)
+              << "  Buscas:   " << t_busca.count() << " s (" << achados << " achados)\n"
+              << "  Percurso: " << t_percurso.count() << " s (" << percorridos << " nós)\n";
+}
+
+/**
+ * @brief Modo de linha de comando que mede o efeito da compactação em uma árvore envelhecida.
+ * 
+ * @details Uso: `programa.out --bench-compactacao [n]`. Insere n códigos em ordem aleatória, remove metade e insere outros tantos, e mede buscas e percursos antes e depois de compactar na ordem de van Emde Boas e em pré-ordem.
+ * @return O código de saída do programa.
+ */
+int modo_bench_compactacao(int argc, char *argv[])
+{
+    int n = argc > 2 ? atoi(argv[2]) : 1000000;
+    if (n <= 0) {
+        std::cerr << "Quantidade inválida: " << argv[2] << "\n";
+        return EXIT_FAILURE;
+    }
+
+    uint64_t estado = SEMENTE_SORTEIO;
+    auto sorteia_codigo = [&]() {
+        return (int) (sorteia(estado) % (uint64_t) (4 * (long long) n));
+    };
+
+    // Envelhece a árvore: os nós ficam na ordem de alocação, misturados com os liberados
+    AVL T;
+    for (int i = 0; i < n; i++)
+        T.insere(sorteia_codigo());
+    for (int i = 0; i < n / 2; i++) {
+        T.remove(sorteia_codigo());
+        T.insere(sorteia_codigo());
+    }
+
+    std::vector<int> consultas(1000000);
+    for (size_t i = 0; i < consultas.size(); i++)
+        consultas[i] = sorteia_codigo();
+
+    mede_localidade("Antes de compactar", T, consultas);
+
+    auto inicio = std::chrono::high_resolution_clock::now();
+    T.compacta(true);
+    auto fim = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = fim - inicio;
+    std::cout << std::fixed << std::setprecision(6) << "Compactação (van Emde Boas): " << elapsed.count() << " s\n";
+    mede_localidade("Depois (van Emde Boas)", T, consultas);
+
+    T.compacta(false);
+    mede_localidade("Depois (pré-ordem)", T, consultas);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Carrega um arquivo de códigos numa árvore radix.
+ * 
+ * @param filename O nome do arquivo.
+ * @param T A árvore.
+ * @return O tempo de carga, em segundos.
+ */
+double carrega_radix(const char *filename, ArvoreRadix &T)
+{
+    unsigned int threads = std::thread::hardware_concurrency();
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<int> v = ler_arquivo_paralelo(filename, threads ? threads : 1);
+    for (int codigo : v)
+        T.insere(codigo);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end - start;
+    return elapsed.count();
+}
+
+/**
+ * @brief Escreve os códigos de um vetor, dez por linha.
+ */
+void escreve_codigos(const std::vector<int> &codigos)
+{
+    for (size_t i = 0; i < codigos.size(); i++)
+        std::cout << codigos[i] << ((i + 1) % 10 == 0 || i + 1 == codigos.size() ? "\n" : " ");
+}
+
+/**
+ * @brief Modo de linha de comando com o menu de opções usando árvores radix no lugar das AVL.
+ * 
+ * @details Uso: `programa.out --radix`. As opções são as mesmas do menu principal; a união e a interseção são calculadas intercalando os códigos em ordem das duas árvores.
+ * @return O código de saída do programa.
+ */
+int modo_radix(int argc, char *argv[])
+{
+    (void) argc;
+    (void) argv;
+    ArvoreRadix T1, T2;
+
+    int opcao;
+    do
+    {
+        std::cout << "\n## --------- Menu de Opções (árvore radix) ---------\n"
+                  << "1: Inserir o código dos itens\n"
+                  << "2: Buscar um item em uma das duas árvores\n"
+                  << "3: Remover um item em uma das duas árvores\n"
+                  << "4: Unir T1 e T2\n"
+                  << "5: Interseccionar T1 e T2\n"
+                  << "6: Buscar elementos em um intervalo\n"
+                  << "7: Sair do programa\n\n"
+                  << ">> Escolha uma opção: ";
+        if (!(std::cin >> opcao))
+            break;
+
+        if (opcao < 1 || opcao > 7)
+        {
+            std::cerr << "\n\n>> Opção inválida! Tente novamente. <<\n";
+            continue;
+        }
+        if (opcao >= 2 && opcao <= 6 && (T1.tamanho() == 0 || T2.tamanho() == 0))
+        {
+            std::cerr << "\n>>> Árvores vazias. Insira elementos primeiro. <<<\n";
+            continue;
+        }
+
+        switch (opcao)
+        {
+        case 1:
+        {
+            char arquivo1[MAX], arquivo2[MAX];
+            std::cout << "\nDigite o nome do primeiro arquivo: ";
+            std::cin >> arquivo1;
+            std::cout << "Digite o nome do segundo arquivo: ";
+            std::cin >> arquivo2;
+
+            double tempo_t1 = carrega_radix(arquivo1, T1);
+            double tempo_t2 = carrega_radix(arquivo2, T2);
+            std::cout << std::fixed << std::setprecision(6)
+                      << "\nT1: " << T1.tamanho() << " códigos, " << T1.memoria() << " bytes, " << tempo_t1 << " segundos\n"
+                      << "T2: " << T2.tamanho() << " códigos, " << T2.memoria() << " bytes, " << tempo_t2 << " segundos\n";
+            int min, max;
+            if (T1.minimo(min) && T1.maximo(max))
+                std::cout << "Menor / maior código em T1: " << min << " / " << max << "\n";
+            if (T2.minimo(min) && T2.maximo(max))
+                std::cout << "Menor / maior código em T2: " << min << " / " << max << "\n";
+            break;
+        }
+        case 2:
+        case 3:
+        {
+            int valor, arvore;
+            std::cout << "\n\n>> Insira o número da árvore (1 para T1, 2 para T2): ";
+            std::cin >> arvore;
+            std::cout << "\n>>> Insira um valor para " << (opcao == 2 ? "buscar" : "remover") << ": ";
+            std::cin >> valor;
+
+            ArvoreRadix *tree = (arvore == 1) ? &T1 : &T2;
+            auto start = std::chrono::high_resolution_clock::now();
+            bool achou = opcao == 2 ? tree->busca(valor) : tree->remove(valor);
+            auto end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> elapsed = end - start;
+
+            std::cout << std::fixed << std::setprecision(6) << "Tempo de " << (opcao == 2 ? "busca" : "remoção") << ": " << elapsed.count() << " segundos\n";
+            if (achou)
+                std::cout << (opcao == 2 ? "\nValor encontrado!\n" : "\nValor removido!\n");
+            else
+                std::cout << "Não encontrado.\n";
+            break;
+        }
+        case 4:
+        case 5:
+        {
+            std::vector<int> a, b, resultado;
+            T1.em_ordem(a);
+            T2.em_ordem(b);
+            if (opcao == 4)
+                std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(resultado));
+            else
+                std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(resultado));
+
+            std::cout << "\n\n## " << (opcao == 4 ? "União" : "Interseção") << " de T1 e T2\n";
+            escreve_codigos(resultado);
+            std::cout << "Códigos na " << (opcao == 4 ? "união" : "interseção") << ": " << resultado.size() << "\n";
+            break;
         }
-        return y;
-    };
+        case 6:
+        {
+            int valor_min, valor_max, arvore;
+            std::cout << "\n\n>> Insira o número da árvore (1 para T1, 2 para T2): ";
+            std::cin >> arvore;
+            std::cout << "\n>>> Insira o valor mínimo: ";
+            std::cin >> valor_min;
+            std::cout << "\n>>> Insira o valor máximo: ";
+            std::cin >> valor_max;
 
-    /**
-     * @brief Insere um nó com uma chave específica na árvore AVL.
-     * 
-     * @param codigo A chave do nó a ser inserido.
-     */
-    void insere(int codigo) {
-        No *z = new No(codigo);
-        insere(z);
-    };
+            ArvoreRadix *tree = (arvore == 1) ? &T1 : &T2;
+            std::vector<int> codigos;
+            auto start = std::chrono::high_resolution_clock::now();
+            tree->busca_intervalo(valor_min, valor_max, codigos);
+            auto end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> elapsed = end - start;
 
-    /**
-     * @brief Remove um nó com uma chave específica da árvore AVL.
-     * 
-     * @param codigo A chave do nó a ser removido.
-     * @return True se o nó foi removido, false caso contrário.
-     */
-    bool remove(int codigo) {
-        No *z = busca(codigo);
-        if (z == nullptr) 
-            return false;
-        
-        remove(z);
-        return true;
-    };
+            escreve_codigos(codigos);
+            std::cout << "\nItens no intervalo: " << codigos.size() << "\n"
+                      << std::fixed << std::setprecision(6) << "Tempo de busca em intervalo: " << elapsed.count() << " segundos\n";
+            break;
+        }
+        case 7:
+            std::cout << "\n\n>> Saindo do programa >>\n";
+            break;
+        }
+    } while (opcao != 7);
 
-    /**
-     * @brief Limpa a árvore AVL.
-     */
-    void limpa() {
-        limpa(raiz);
-        raiz = nullptr;
-    };
+    return EXIT_SUCCESS;
+}
 
-    /**
-     * @brief Une a árvore AVL atual com outra árvore AVL.
-     *
-     * @param T Referência para a árvore AVL a ser unida.
-     * @param destino Referência para a árvore AVL onde o resultado será armazenado.
-     */
-    void uniao(AVL &T, AVL &destino)
-    {
-        uniao(this->raiz, destino);
-        uniao(T.raiz, destino);
+/**
+ * @brief Modo de linha de comando que compara a árvore radix com a AVL.
+ * 
+ * @details Uso: `programa.out --bench-radix [n]`. Insere n códigos distintos e densos em ordem aleatória, busca todos, busca um intervalo com um décimo deles e remove metade, escrevendo os tempos e a memória de cada estrutura.
+ * @return O código de saída do programa.
+ */
+int modo_bench_radix(int argc, char *argv[])
+{
+    int n = argc > 2 ? atoi(argv[2]) : 1000000;
+    if (n <= 0) {
+        std::cerr << "Quantidade inválida: " << argv[2] << "\n";
+        return EXIT_FAILURE;
     }
 
-    /**
-     * @brief Intersecciona duas árvores AVL e armazena o resultado em uma terceira árvore.
-     * 
-     * @param T1 Referência para a primeira árvore AVL.
-     * @param T2 Referência para a segunda árvore AVL.
-     * @param T3 Referência para a árvore AVL onde o resultado será armazenado.
-     */
-    void intersecao(AVL &T1, AVL &T2, AVL &T3) {
-        intersecao(T1.raiz, T2, T3);
-    };
+    // Códigos 0..n-1 embaralhados (Fisher-Yates com xorshift)
+    std::vector<int> codigos(n);
+    for (int i = 0; i < n; i++)
+        codigos[i] = i;
+    uint64_t estado = SEMENTE_SORTEIO;
+    for (int i = n - 1; i > 0; i--)
+        std::swap(codigos[i], codigos[sorteia(estado) % (uint64_t) (i + 1)]);
 
-    /**
-     * @brief Busca elementos dentro de um intervalo de chaves.
-     * 
-     * @param min O valor mínimo da chave.
-     * @param max O valor máximo da chave.
-     */
-    void busca_intervalo(int min, int max) {
-        busca_intervalo(raiz, min, max);
-    };
+    AVL A;
+    ArvoreRadix R;
+    std::chrono::duration<double> t[2][4];
+    size_t achados[2] = {0, 0}, no_intervalo[2] = {0, 0};
+    size_t memoria[2];
 
-    /**
-     * @brief Escreve a árvore AVL na saída padrão.
-     * 
-     * @param prefixo A string de prefixo para formatar a saída.
-     * @param x Ponteiro para o nó de onde a escrita começa.
-     */
-    void escreve(const char* prefixo = "", No* x = nullptr, bool isLeft = true) {
-        if (x != nullptr) {
-            std::cout << prefixo;
-            std::cout << (isLeft ? "├── " : "└── ");
-            x->escreve("\n");
+    auto inicio = std::chrono::high_resolution_clock::now();
+    for (int codigo : codigos)
+        A.insere(codigo);
+    auto fim = std::chrono::high_resolution_clock::now();
+    t[0][0] = fim - inicio;
+    memoria[0] = A.memoria_nos();
 
-            // Cria novos prefixos para os filhos esquerdo e direito
-            char novoPrefixoEsq[100];
-            char novoPrefixoDir[100];
+    inicio = std::chrono::high_resolution_clock::now();
+    for (int codigo : codigos)
+        R.insere(codigo);
+    fim = std::chrono::high_resolution_clock::now();
+    t[1][0] = fim - inicio;
+    memoria[1] = R.memoria();
 
-            copia_string(novoPrefixoEsq, prefixo);
-            copia_string(novoPrefixoDir, prefixo);
+    inicio = std::chrono::high_resolution_clock::now();
+    for (int codigo : codigos)
+        achados[0] += A.busca(codigo) != nullptr;
+    fim = std::chrono::high_resolution_clock::now();
+    t[0][1] = fim - inicio;
 
-            if (isLeft) {
-                concatena_string(novoPrefixoEsq, "│   ");
-                concatena_string(novoPrefixoDir, "    ");
-            } else {
-                concatena_string(novoPrefixoEsq, "    ");
-                concatena_string(novoPrefixoDir, "    ");
-            }
+    inicio = std::chrono::high_resolution_clock::now();
+    for (int codigo : codigos)
+        achados[1] += R.busca(codigo);
+    fim = std::chrono::high_resolution_clock::now();
+    t[1][1] = fim - inicio;
 
-            escreve(novoPrefixoEsq, x->esq, true);
-            escreve(novoPrefixoDir, x->dir, false);
-        }
-    };
-    /**
-     * @brief Copia uma string para outra.
-     * @param destino Ponteiro para a string de destino.
-     * @param origem Ponteiro para a string de origem.
-     */
-    void copia_string(char *destino, const char *origem) {
-        while (*origem)
-        {
-            *destino++ = *origem++;
-        }
-        *destino = '\0';
-    }
+    int min = n / 3, max = n / 3 + n / 10;
+    inicio = std::chrono::high_resolution_clock::now();
+    for (No *x = A.teto(min); x != nullptr && x->get_codigo() <= max; x = A.sucessor(x))
+        no_intervalo[0]++;
+    fim = std::chrono::high_resolution_clock::now();
+    t[0][2] = fim - inicio;
 
-    /**
-     * @brief Concatena uma string a outra.
-     * @param destino Ponteiro para a string de destino.
-     * @param origem Ponteiro para a string de origem.
-     */
-    void concatena_string(char *destino, const char *origem) {
-        while (*destino)
-        {
-            destino++;
-        }
-        copia_string(destino, origem);
-    };
-};
+    std::vector<int> intervalo;
+    inicio = std::chrono::high_resolution_clock::now();
+    R.busca_intervalo(min, max, intervalo);
+    fim = std::chrono::high_resolution_clock::now();
+    t[1][2] = fim - inicio;
+    no_intervalo[1] = intervalo.size();
+
+    inicio = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < codigos.size(); i += 2)
+        A.remove(codigos[i]);
+    fim = std::chrono::high_resolution_clock::now();
+    t[0][3] = fim - inicio;
 
+    inicio = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < codigos.size(); i += 2)
+        R.remove(codigos[i]);
+    fim = std::chrono::high_resolution_clock::now();
+    t[1][3] = fim - inicio;
+
+    const char *nomes[2] = {"AVL", "Radix"};
+    for (int e = 0; e < 2; e++)
+        std::cout << nomes[e] << ":\n" << std::fixed << std::setprecision(6)
+                  << "  Inserção:  " << t[e][0].count() << " s (" << memoria[e] << " bytes)\n"
+                  << "  Busca:     " << t[e][1].count() << " s (" << achados[e] << " achados)\n"
+                  << "  Intervalo: " << t[e][2].count() << " s (" << no_intervalo[e] << " códigos)\n"
+                  << "  Remoção:   " << t[e][3].count() << " s\n";
+    A.limpa();
+    return EXIT_SUCCESS;
+}
 
 /**
- * @brief Conta o número de linhas em um arquivo de texto.
+ * @brief Modo de linha de comando que compara a remoção de um intervalo com remoções individuais.
  * 
- * @param filename O nome do arquivo de texto.
- * @return O número de linhas no arquivo.
+ * @details Uso: `programa.out --bench-remocao [n]`. Carrega duas árvores com os códigos 0..n-1 e remove a metade do meio de cada uma, código a código numa e com `remove_intervalo` na outra.
+ * @return O código de saída do programa.
  */
-int contar_linhas(const char *filename)
+int modo_bench_remocao(int argc, char *argv[])
 {
-    FILE *file = fopen(filename, "r");
-    if (file == NULL)
-    {
-        std::cerr << "Erro ao abrir o arquivo: " << filename << std::endl;
-        exit(EXIT_FAILURE);
+    int n = argc > 2 ? atoi(argv[2]) : 1000000;
+    if (n <= 0) {
+        std::cerr << "Quantidade inválida: " << argv[2] << "\n";
+        return EXIT_FAILURE;
     }
 
-    int linhas = 0;
-    char ch;
-    while ((ch = fgetc(file)) != EOF)
-    {
-        if (ch == '\n')
-        {
-            linhas++;
-        }
+    std::vector<int> codigos(n);
+    for (int i = 0; i < n; i++)
+        codigos[i] = i;
+    AVL A, B;
+    A.carrega_ordenado(codigos);
+    B.carrega_ordenado(codigos);
+
+    int min = n / 4, max = n / 4 + n / 2 - 1;
+    long removidos_a = 0;
+    auto inicio = std::chrono::high_resolution_clock::now();
+    for (int codigo = min; codigo <= max; codigo++)
+        removidos_a += A.remove(codigo);
+    auto meio = std::chrono::high_resolution_clock::now();
+    long removidos_b = B.remove_intervalo(min, max);
+    auto fim = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double> t_individual = meio - inicio, t_intervalo = fim - meio;
+    std::cout << std::fixed << std::setprecision(6)
+              << "Remoções individuais: " << t_individual.count() << " s (" << removidos_a << " removidos)\n"
+              << "Remoção do intervalo: " << t_intervalo.count() << " s (" << removidos_b << " removidos)\n"
+              << "Restantes: " << B.agrega_intervalo(INT_MIN, INT_MAX).itens << "\n";
+    A.limpa();
+    B.limpa();
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Modo de linha de comando que compara a diferença por hashes com a busca código a código.
+ * 
+ * @details Uso: `programa.out --bench-diferenca [n] [d]`. Carrega duas cópias de n códigos, aplica d inserções e remoções aleatórias na segunda e calcula o que mudou com `diferenca_rapida` e buscando cada código de uma cópia na outra.
+ * @return O código de saída do programa.
+ */
+int modo_bench_diferenca(int argc, char *argv[])
+{
+    int n = argc > 2 ? atoi(argv[2]) : 1000000;
+    int d = argc > 3 ? atoi(argv[3]) : 300;
+    if (n <= 0 || d < 0) {
+        std::cerr << "Uso: programa.out --bench-diferenca [n] [d]\n";
+        return EXIT_FAILURE;
     }
 
-    if (ferror(file))
-    {
-        std::cerr << "Erro de leitura no arquivo: " << filename << std::endl;
-        fclose(file);
-        exit(EXIT_FAILURE);
+    uint64_t estado = SEMENTE_SORTEIO;
+    auto sorteia_codigo = [&]() {
+        return (int) (sorteia(estado) % (uint64_t) (4 * (long long) n));
+    };
+
+    std::vector<int> codigos(n);
+    for (int i = 0; i < n; i++)
+        codigos[i] = 4 * i;
+    AVL A, B;
+    A.carrega_ordenado(codigos);
+    B.carrega_ordenado(codigos);
+    // Os inseridos são ímpares, e portanto novos
+    for (int i = 0; i < d; i++) {
+        if (i % 2 == 0)
+            B.insere(sorteia_codigo() | 1);
+        else
+            B.remove(4 * (sorteia_codigo() / 4));
     }
 
-    fclose(file);
-    return linhas;
+    auto inicio = std::chrono::high_resolution_clock::now();
+    Diferenca diferenca = A.diferenca_rapida(B);
+    auto meio = std::chrono::high_resolution_clock::now();
+
+    // Busca código a código, nos dois sentidos
+    long long adicionados = 0, removidos = 0;
+    std::vector<int> a, b;
+    A.em_ordem(a);
+    B.em_ordem(b);
+    for (size_t i = 0; i < a.size(); i++)
+        removidos += B.busca(a[i]) == nullptr;
+    for (size_t i = 0; i < b.size(); i++)
+        adicionados += A.busca(b[i]) == nullptr;
+    auto fim = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double> t_rapida = meio - inicio, t_busca = fim - meio;
+    std::cout << std::fixed << std::setprecision(6)
+              << "Diferença por hashes: " << t_rapida.count() << " s (" << diferenca.adicionados.size() << " adicionados, " << diferenca.removidos.size() << " removidos)\n"
+              << "Busca código a código: " << t_busca.count() << " s (" << adicionados << " adicionados, " << removidos << " removidos)\n";
+    A.limpa();
+    B.limpa();
+    return EXIT_SUCCESS;
 }
 
 /**
- * @brief Lê um arquivo de texto e retorna um vetor de inteiros.
+ * @brief Modo de linha de comando que compara a ingestão na AVL e no inventário LSM.
  * 
- * @param filename O nome do arquivo de texto.
- * @return Um vetor de inteiros lidos do arquivo.
+ * @details Uso: `programa.out --ingestao [n] [corridas_por_nivel]`. Aplica n operações (nove inserções de códigos novos para cada remoção de um código já inserido) nas duas estruturas e depois faz um milhão de buscas aleatórias em cada uma, conferindo os resultados.
+ * @return O código de saída do programa.
  */
-void ler_arquivo(const char *filename, int valores[], int &tamanho)
+int modo_ingestao(int argc, char *argv[])
 {
-    tamanho = contar_linhas(filename);
-    if (tamanho > MAX)
-    {
-        std::cerr << "O arquivo contém mais elementos do que o tamanho máximo permitido ("
-                  << MAX << "). Redefina o limite.\n";
-        exit(EXIT_FAILURE);
+    int n = argc > 2 ? atoi(argv[2]) : 1000000;
+    int corridas_por_nivel = argc > 3 ? atoi(argv[3]) : 4;
+    if (n <= 0 || corridas_por_nivel < 2) {
+        std::cerr << "Uso: programa.out --ingestao [n] [corridas_por_nivel]\n";
+        return EXIT_FAILURE;
     }
 
-    FILE *file = fopen(filename, "r");
-    if (file == NULL)
-    {
-        std::cerr << "Erro ao abrir o arquivo: " << filename << std::endl;
-        exit(EXIT_FAILURE);
-    }
+    uint64_t estado = SEMENTE_SORTEIO;
 
-    // Lê os valores do arquivo
+    // i * 2654435761 é uma permutação dos inteiros de 32 bits: os códigos inseridos são distintos
+    std::vector<int> codigos(n);
+    std::vector<bool> remocao(n);
+    int inseridos = 0;
+    for (int i = 0; i < n; i++) {
+        remocao[i] = i % 10 == 9;
+        if (remocao[i])
+            codigos[i] = (int) ((uint32_t) (sorteia(estado) % (uint64_t) inseridos) * 2654435761u);
+        else
+            codigos[i] = (int) ((uint32_t) inseridos++ * 2654435761u);
+    }
 
-    
-    int i = 0;
-    while (fscanf(file, "%d", &valores[i]) != EOF && i < tamanho)
-    {
-        i++;
+    AVL A;
+    auto inicio = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < n; i++) {
+        if (remocao[i])
+            A.remove(codigos[i]);
+        else
+            A.insere(codigos[i]);
     }
+    auto fim = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> t_avl = fim - inicio;
 
-    if (ferror(file))
-    {
-        std::cerr << "Erro de leitura no arquivo: " << filename << std::endl;
-        fclose(file);
-        exit(EXIT_FAILURE);
+    InventarioLSM L(65536, corridas_por_nivel);
+    inicio = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < n; i++) {
+        if (remocao[i])
+            L.remove(codigos[i]);
+        else
+            L.insere(codigos[i]);
     }
+    fim = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> t_lsm = fim - inicio;
 
-    fclose(file);
+    std::cout << std::fixed << std::setprecision(6)
+              << "Ingestão na AVL: " << t_avl.count() << " s\n"
+              << "Ingestão no LSM: " << t_lsm.count() << " s (" << L.get_corridas() << " corridas, " << L.get_intercalacoes() << " intercalações, "
+              << std::setprecision(2) << "amplificação de escrita " << L.get_amplificacao() << ")\n" << std::setprecision(6);
+
+    std::vector<int> consultas(1000000);
+    for (size_t i = 0; i < consultas.size(); i++)
+        consultas[i] = (int) ((uint32_t) (sorteia(estado) % (uint64_t) (2 * (long long) inseridos)) * 2654435761u);
+
+    long long achados_avl = 0, achados_lsm = 0;
+    inicio = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < consultas.size(); i++)
+        achados_avl += A.busca(consultas[i]) != nullptr;
+    auto meio = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < consultas.size(); i++)
+        achados_lsm += L.busca(consultas[i]);
+    fim = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double> b_avl = meio - inicio, b_lsm = fim - meio;
+    std::cout << consultas.size() << " buscas na AVL: " << b_avl.count() << " s (" << achados_avl << " achados)\n"
+              << consultas.size() << " buscas no LSM: " << b_lsm.count() << " s (" << achados_lsm << " achados)\n";
+    A.limpa();
+    return achados_avl == achados_lsm ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Escreve as estatísticas do filtro de Bloom de uma árvore.
+ * 
+ * @param nome O nome da árvore.
+ * @param T A árvore.
+ */
+void escreve_estatisticas_bloom(const char *nome, const AVL &T)
+{
+    const FiltroBloom *f = T.get_filtro_bloom();
+    if (f == nullptr)
+        return;
+
+    std::cout << "\nFiltro de Bloom de " << nome << ":\n"
+              << "Consultas: " << f->get_consultas() << "\n"
+              << "Descartadas pelo filtro: " << f->get_descartes() << "\n"
+              << "Falsos positivos: " << f->get_falsos_positivos() << "\n"
+              << std::fixed << std::setprecision(4)
+              << "Taxa de falsos positivos medida: " << 100.0 * f->taxa_falsos_medida() << "%\n"
+              << "Taxa de falsos positivos estimada: " << 100.0 * f->taxa_falsos_estimada() << "%\n"
+              << "Memória do filtro: " << f->memoria() << " bytes\n";
 }
 
 int main(int argc, char *argv[])
 {
 
-    AVL T1, T2, T3_intersecao, T3_uniao;
+    if (argc > 1 && strcmp(argv[1], "--paginada") == 0)
+        return modo_paginado(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--bench-balanceamento") == 0)
+        return modo_bench_balanceamento(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--fragmentado") == 0)
+        return modo_fragmentado(argc, argv);
+#ifdef __linux__
+    if (argc > 1 && strcmp(argv[1], "--servidor") == 0)
+        return modo_servidor(argc, argv);
+#endif
+    if (argc > 1 && strcmp(argv[1], "--cliente") == 0)
+        return modo_cliente(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--externo") == 0)
+        return modo_externo(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--multiplos") == 0)
+        return modo_multiplos(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--compactado") == 0)
+        return modo_compactado(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--bench-compactacao") == 0)
+        return modo_bench_compactacao(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--radix") == 0)
+        return modo_radix(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--bench-radix") == 0)
+        return modo_bench_radix(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--bench-remocao") == 0)
+        return modo_bench_remocao(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--bench-diferenca") == 0)
+        return modo_bench_diferenca(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--ingestao") == 0)
+        return modo_ingestao(argc, argv);
+
+    // Índice hash e filtro de Bloom opcionais em T1 e T2
+    bool indice_hash = false, bloom = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--indice-hash") == 0)
+            indice_hash = true;
+        else if (strcmp(argv[i], "--bloom") == 0)
+            bloom = true;
+    }
+
+    AVL T1, T2;
+    if (indice_hash)
+    {
+        T1.ativa_indice_hash();
+        T2.ativa_indice_hash();
+    }
+    if (bloom)
+    {
+        T1.ativa_filtro_bloom();
+        T2.ativa_filtro_bloom();
+    }
+
+    // União e interseção mantidas a cada inserção e remoção em T1 e T2
+    VisaoConjuntos visoes(T1, T2);
+    AVL &T3_uniao = visoes.get_uniao();
+    AVL &T3_intersecao = visoes.get_intersecao();
 
     int opcao;
     do
@@ -906,38 +7218,41 @@ int main(int argc, char *argv[])
         // --------------- Inserção ----------------
         case 1:
         {
-            int v1[MAX], v2[MAX];
-            int tamanho_v1, tamanho_v2;
             char arquivo1[MAX], arquivo2[MAX];
 
             std::cout << "\nDigite o nome do primeiro arquivo: ";
             std::cin >> arquivo1;
-            ler_arquivo(arquivo1, v1, tamanho_v1);
 
             std::cout << "Digite o nome do segundo arquivo: ";
             std::cin >> arquivo2;
-            ler_arquivo(arquivo2, v2, tamanho_v2);
 
             std::cout << "\n\n## Inserção de produtos em T1 e T2\n\n";
-            auto start = std::chrono::high_resolution_clock::now(); //medindo inserção T1
-            for (int i = 0; i < tamanho_v1; ++i)
-                T1.insere(v1[i]);
+
+            // T1 e T2 são carregadas ao mesmo tempo, cada uma com metade das threads
+            int threads = std::thread::hardware_concurrency();
+            threads = threads > 1 ? threads / 2 : 1;
+
+            double tempo_t1, tempo_t2;
+            auto start = std::chrono::high_resolution_clock::now();
+            std::thread carga_t1([&]() { tempo_t1 = carrega_paralelo(arquivo1, T1, threads); });
+            tempo_t2 = carrega_paralelo(arquivo2, T2, threads);
+            carga_t1.join();
             auto end = std::chrono::high_resolution_clock::now();
             std::chrono::duration<double> elapsed = end - start;
-            
-            std::cout << "\n";
-            start = std::chrono::high_resolution_clock::now();  //medindo inserção T2
-            for (int i = 0; i < tamanho_v2; ++i)
-                T2.insere(v2[i]);
-            end = std::chrono::high_resolution_clock::now();
-            elapsed = end - start;
            
             std::cout << "T1:\n";
             T1.escreve("", T1.get_raiz());
-            std::cout << std::fixed << std::setprecision(6)<< "\nTempo de inserção em T1: " << elapsed.count() << " segundos\n";
+            std::cout << std::fixed << std::setprecision(6)<< "\nTempo de inserção em T1: " << tempo_t1 << " segundos\n";
             std::cout << "T2:\n";
             T2.escreve("", T2.get_raiz());
-            std::cout << std::fixed << std::setprecision(6)<< "\nTempo de inserção em T2: " << elapsed.count() << " segundos\n";
+            std::cout << std::fixed << std::setprecision(6)<< "\nTempo de inserção em T2: " << tempo_t2 << " segundos\n";
+            std::cout << std::fixed << std::setprecision(6)<< "Tempo total de carga: " << elapsed.count() << " segundos\n";
+
+            if (indice_hash)
+            {
+                std::cout << "\nMemória dos nós / do índice hash em T1: " << T1.memoria_nos() << " / " << T1.memoria_indice_hash() << " bytes\n";
+                std::cout << "Memória dos nós / do índice hash em T2: " << T2.memoria_nos() << " / " << T2.memoria_indice_hash() << " bytes\n";
+            }
 
             break;
         }
@@ -974,6 +7289,14 @@ int main(int argc, char *argv[])
                 else
                 {
                     std::cout << "Não encontrado.\n";
+
+                    // Vizinhos mais próximos do código buscado
+                    No *p = tree->piso(valor_busca);
+                    No *t = tree->teto(valor_busca);
+                    if (p != nullptr)
+                        std::cout << "Maior código abaixo: " << p->get_codigo() << "\n";
+                    if (t != nullptr)
+                        std::cout << "Menor código acima: " << t->get_codigo() << "\n";
                 }
                 break;
             }
@@ -1024,15 +7347,9 @@ int main(int argc, char *argv[])
                 std::cerr << "\n>>> Árvores vazias. Insira elementos primeiro. <<<\n";
                 break;
             } else {
-                auto start = std::chrono::high_resolution_clock::now();
-                T1.uniao(T2, T3_uniao);
-                auto end = std::chrono::high_resolution_clock::now();
-
-                std::chrono::duration<double> elapsed = end - start;
-                
-               
+                // A visão já está atualizada: basta escrevê-la
                 T3_uniao.escreve("", T3_uniao.get_raiz());
-                std::cout << std::fixed << std::setprecision(6)<< "Tempo de união: " << elapsed.count() << " segundos\n";
+                std::cout << "Códigos na união: " << T3_uniao.agrega_intervalo(INT_MIN, INT_MAX).itens << "\n";
                 break;
             }
         }
@@ -1046,14 +7363,12 @@ int main(int argc, char *argv[])
                 std::cerr << "\n>>> Árvores vazias. Insira elementos primeiro. <<<\n";
                 break;
             } else {
-                auto start = std::chrono::high_resolution_clock::now();    
-                T3_intersecao.intersecao(T1, T2, T3_intersecao);
-                auto end = std::chrono::high_resolution_clock::now();
-                
-                std::chrono::duration<double> elapsed = end - start;
-                std::cout << std::fixed << std::setprecision(6)<< "Tempo de interseção: " << elapsed.count() << " segundos\n";
+                // A visão já está atualizada: basta escrevê-la
+                if (bloom)
+                    escreve_estatisticas_bloom("T2", T2);
                 
                 T3_intersecao.escreve("", T3_intersecao.get_raiz());
+                std::cout << "Códigos na interseção: " << T3_intersecao.agrega_intervalo(INT_MIN, INT_MAX).itens << "\n";
                 break;  
             }
         }
@@ -1085,6 +7400,16 @@ int main(int argc, char *argv[])
 
                 std::chrono::duration<double> elapsed = end - start;
                 std::cout << std::fixed << std::setprecision(6)<< "Tempo de busca em intervalo: " << elapsed.count() << " segundos\n";
+
+                start = std::chrono::high_resolution_clock::now();
+                Resumo r = tree->agrega_intervalo(valor_min, valor_max);
+                end = std::chrono::high_resolution_clock::now();
+                elapsed = end - start;
+
+                std::cout << "\nItens no intervalo: " << r.itens
+                          << "\nEstoque total: " << r.estoque_total
+                          << std::fixed << std::setprecision(2) << "\nValor total: " << r.valor_total << "\n";
+                std::cout << std::fixed << std::setprecision(6)<< "Tempo de agregação: " << elapsed.count() << " segundos\n";
                 break;
             }
         }
@@ -1108,8 +7433,6 @@ int main(int argc, char *argv[])
     // Liberar toda memória nas árvores
     T1.limpa();
     T2.limpa();
-    T3_intersecao.limpa();
-    T3_uniao.limpa();
 
     return 0;
 }